@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+#include "tile.h"
+
+// Collision queries between placed tiles without comparing against every
+// placed tile and part pair.
+
+// Placed tile parts keyed by their absolute left column. A part ends at most
+// `widest` columns after it starts, so only parts starting in
+// (x - widest, x + w) can overlap columns [x, x + w); a query walks those
+// instead of every placed tile.
+class PartIndex {
+private:
+    struct Entry {
+        int end;     // Absolute right column, exclusive
+        int top;     // First row
+        int bottom;  // Last row, exclusive
+        size_t tile;
+    };
+
+    std::multimap<int, Entry> parts;
+    int widest = 0;
+
+public:
+    void add(size_t tile, const TileView& placed) {
+        for (const auto& part : placed.parts) {
+            int start = placed.positionX + part.offsetX;
+            parts.emplace(start, Entry{start + part.width, part.offsetY, part.offsetY + part.height, tile});
+            widest = std::max(widest, part.width);
+        }
+    }
+
+    // Removes the parts added for the tile while it was at placed.positionX
+    void remove(size_t tile, const TileView& placed) {
+        for (const auto& part : placed.parts) {
+            auto range = parts.equal_range(placed.positionX + part.offsetX);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second.tile == tile) {
+                    parts.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+
+    // True if a part of the tile, at its positionX, overlaps a part of any
+    // indexed tile other than `skip`. Rectangles overlap when they share an
+    // inner point, as in doesTileCollideWithOthers.
+    bool collides(const TileView& tile, size_t skip) const {
+        for (const auto& part : tile.parts) {
+            int start = tile.positionX + part.offsetX, end = start + part.width;
+            int top = part.offsetY, bottom = part.offsetY + part.height;
+
+            for (auto it = parts.upper_bound(start - widest); it != parts.end() && it->first < end; ++it) {
+                const Entry& other = it->second;
+                if (other.tile != skip && other.end > start && other.bottom > top && other.top < bottom) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    void clear() {
+        parts.clear();
+        widest = 0;
+    }
+};
+
+// Two tiles of a placement sharing the cell (row, column)
+struct Overlap {
+    size_t first, second;
+    int row, column;
+};
+
+// Overlapping tiles of a finished placement, at most `limit` of them, each
+// reported with a cell the two tiles share. Tiles may be a TileArrays or a
+// TileFileView. Each row's parts are sorted by start and swept once, keeping
+// the furthest-reaching part and the furthest-reaching part of any other
+// tile, so the check is n log n in the part rows rather than quadratic.
+// Parts of the same tile may overlap each other.
+template <typename Tiles>
+std::vector<Overlap> findOverlaps(const Tiles& tiles, size_t limit = 100) {
+    struct Span {
+        int start, end;
+        size_t tile;
+        bool operator<(const Span& other) const { return start < other.start; }
+    };
+    const size_t none = static_cast<size_t>(-1);
+
+    std::vector<std::vector<Span>> rows;
+    for (size_t i = 0; i < tiles.tileCount(); ++i) {
+        for (int p = tiles.partBegin[i]; p < tiles.partBegin[i + 1]; ++p) {
+            if (tiles.width[p] <= 0 || tiles.height[p] <= 0) continue;
+            int start = tiles.positionX[i] + tiles.offsetX[p];
+            int bottom = tiles.offsetY[p] + tiles.height[p];
+            if (static_cast<int>(rows.size()) < bottom) rows.resize(bottom);
+            for (int row = std::max(0, static_cast<int>(tiles.offsetY[p])); row < bottom; ++row) {
+                rows[row].push_back({start, start + tiles.width[p], i});
+            }
+        }
+    }
+
+    std::vector<Overlap> overlaps;
+    for (size_t row = 0; row < rows.size() && overlaps.size() < limit; ++row) {
+        std::vector<Span>& spans = rows[row];
+        std::sort(spans.begin(), spans.end());
+
+        // reach ends furthest right of all spans so far, other furthest right
+        // of those belonging to another tile than reach
+        Span reach{0, 0, none}, other{0, 0, none};
+        for (const Span& span : spans) {
+            const Span& blocker = (reach.tile != span.tile) ? reach : other;
+            if (blocker.tile != none && blocker.end > span.start) {
+                overlaps.push_back({std::min(blocker.tile, span.tile), std::max(blocker.tile, span.tile),
+                                    static_cast<int>(row), span.start});
+                if (overlaps.size() >= limit) break;
+            }
+
+            if (span.tile == reach.tile) {
+                reach.end = std::max(reach.end, span.end);
+            } else if (span.tile == other.tile) {
+                other.end = std::max(other.end, span.end);
+                if (other.end > reach.end) std::swap(reach, other);
+            } else if (span.end > reach.end) {
+                other = reach;
+                reach = span;
+            } else if (span.end > other.end) {
+                other = span;
+            }
+        }
+    }
+    return overlaps;
+}
@@ -4,6 +4,7 @@ from plotting import *
 from readings import *
 from tile_process import *
 import os
+import subprocess
 
 def read_packing_results(filename):
     result = []
@@ -99,4 +100,19 @@ def double_pack_with_c(excitations, separation, seam_lst, if_double = False):
     filename = './tiles/second_result_tiles.txt'
     bounding_width, placed_tiles_lst = read_packing_results(filename)
     print(f"second output has {len(placed_tiles_lst)} tiles")
-    return bounding_width, placed_tiles_lst
\ No newline at end of file
+    return bounding_width, placed_tiles_lst
+
+def double_pack_two_pass_with_c(excitations, separations, seam_lst):
+    """Both passes of double_pack_with_c in one double_packing run, once for
+    each separation; returns the narrowest second-pass result."""
+    tiles = create_circuit_tile(excitations)
+    print(f"first input has {len(tiles)} tiles")
+    filename = "./tiles/inter_intra_tiles.txt"
+    tiles = sorted(tiles, key=lambda tile: tile[0][1], reverse=True)
+    export_inter_intra(tiles, filename, seam_lst)
+    c_directory = "../lib/double_packing.exe"
+    subprocess.run([c_directory, "--two-pass"] + [str(separation) for separation in separations])
+    filename = './tiles/second_result_tiles.txt'
+    bounding_width, placed_tiles_lst = read_packing_results(filename)
+    print(f"second output has {len(placed_tiles_lst)} tiles")
+    return bounding_width, placed_tiles_lst
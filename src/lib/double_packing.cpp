@@ -1,317 +1,72 @@
 #include <iostream>
 #include <vector>
 #include <fstream>
-#include <algorithm>
 #include <sstream>
-#include <climits>
-#include <cmath>
-
-
-
-#define MAX_WIDTH 1000000
-#define MAX_HEIGHT 100
-
-struct TilePart {
-    int width, height, offsetX, offsetY;
-    TilePart(int w, int h, int dx, int dy) : width(w), height(h), offsetX(dx), offsetY(dy) {}
-};
-
-class Tile {
-public:
-    std::vector<TilePart> parts;
-    bool isInter;
-    int positionX;  // Absolute x position for preplaced tiles or placed free tiles
-    int separation = 0;
-    explicit Tile(const std::vector<TilePart>& p, bool inter = false, int x = 0)
-        : parts(p), isInter(inter), positionX(x) {}
-
-    void print() const {
-        std::cout << (isInter ? "Inter" : "Movable") << " tile";
-        if (isInter) std::cout << " at x=" << positionX;
-        std::cout << " with " << parts.size() << " parts:\n";
-        for (const auto& part : parts) {
-            std::cout << "  " << part.width << "x" << part.height 
-                      << " at offset (" << part.offsetX << "," << part.offsetY << ")\n";
-        }
-    }
-
-    int getTotalWidth() const {
-        int maxX = 0;
-        for (const auto& part : parts) {
-            maxX = std::max(maxX, part.offsetX + part.width);
-        }
-        return maxX;
-    }
+#include <string>
+#include <optional>
+#include <utility>
+#include <algorithm>
+#include "tile_packing.h"
+#include "tile_io.h"
 
-    int getTotalHeight() const {
-        int maxY = 0;
-        for (const auto& part : parts) {
-            maxY = std::max(maxY, part.offsetY + part.height);
-        }
-        return maxY;
-    }
-};
+// Intra tiles are packed first-fit on their own cells; inter tiles also keep
+// a separation free to their right (see InterSeparation)
+using DoublePacker = TilePacker<DefaultGrid, FirstFit, InterSeparation>;
 
-class TilePacker {
-private:
-    std::vector<std::vector<bool>> intra_grid;
-    std::vector<std::vector<bool>> inter_grid;
-    std::vector<Tile> placedTiles;
+// Separation of the inter tiles. The first pass keeps the widest tile read so
+// far (at least min_separation); the second, double-packed pass keeps
+// min_separation.
+struct SeparationRule {
     int min_separation = 0;
-    int boundingWidth = 0;
-    int boundingHeight = 0;
     bool if_double = false;
 
-    void initializeGrid() {
-        intra_grid.resize(MAX_HEIGHT, std::vector<bool>(MAX_WIDTH, false));
-        inter_grid.resize(MAX_HEIGHT, std::vector<bool>(MAX_WIDTH, false));
-    }
-
-    bool intra_fits(int x, const Tile& tile) const {
-        for (const auto& part : tile.parts) {
-            int endX = x + part.offsetX + part.width;
-            int endY = part.offsetY + part.height;
-
-            if (endX > MAX_WIDTH || endY > MAX_HEIGHT) {
-                return false;
-            }
-
-            for (int row = part.offsetY; row < endY; ++row) {
-                for (int col = x + part.offsetX; col < endX; ++col) {
-                    if (intra_grid[row][col]) {
-                        return false;
-                    }
-                }
-            }
-        }
-        return true;
-    }
-
-    bool inter_fits(int x, const Tile& tile) const {
-        for (const auto& part : tile.parts) {
-            int endX = x + part.offsetX + part.width + tile.separation;
-            int endY = part.offsetY + part.height;
-
-            if (endX > MAX_WIDTH || endY > MAX_HEIGHT) {
-                return false;
-            }
-
-            for (int row = part.offsetY; row < endY; ++row) {
-                for (int col = x + part.offsetX; col < endX; ++col) {
-                    if (inter_grid[row][col]) {
-                        return false;
-                    }
-                }
-            }
-        }
-        return true;
-    }
-
-    void intra_occupied(int x, const Tile& tile) {
-        for (const auto& part : tile.parts) {
-            for (int row = part.offsetY; row < part.offsetY + part.height; ++row) {
-                for (int col = x + part.offsetX; col < x + part.offsetX + part.width; ++col) {
-                    intra_grid[row][col] = true;
-                    inter_grid[row][col] = true;
-                }
-            }
-            boundingHeight = std::max(boundingHeight, part.offsetY + part.height);
-        }
-    }
-
-    void inter_occupied(int x, const Tile& tile) {
-        for (const auto& part : tile.parts) {
-            for (int row = part.offsetY; row < part.offsetY + part.height; ++row) {
-                // Occupied the intra grid
-                for (int col = x + part.offsetX; col < x + part.offsetX + part.width; ++col) {
-                    intra_grid[row][col] = true;
-                }
-                // Occupied the inter grid
-                for (int col = x + part.offsetX; col < x + part.offsetX + part.width + tile.separation; ++col) {
-                    inter_grid[row][col] = true;
-                }
-            }
-            boundingHeight = std::max(boundingHeight, part.offsetY + part.height);
-        }
-    }
-
-public:
-    TilePacker() {
-        initializeGrid();
-    }
-
-    void setSeparation(int sep) {
-        if (sep < 0) {
-            std::cerr << "Separation must be non-negative.\n";
-            return;
-        }
-        min_separation = sep;
-    }
-
-    void setDouble(bool flag) {
-        if_double = flag;
-        if(if_double){
-            std::cout<<"right"<<std::endl;
-        }
-        else{
-            std::cout<<"wrong"<<std::endl;
+    int separation(int max_width) const {
+        if (if_double) {
+            return min_separation;
         }
+        return std::max(max_width, min_separation);
     }
+};
 
-    bool placeIntraTile(const std::vector<TilePart>& parts) {
-        Tile tile(parts);
-        for (int x = 0; x <= MAX_WIDTH - tile.getTotalWidth(); ++x) {
-            if (intra_fits(x, tile)) {
-                intra_occupied(x, tile);
-                boundingWidth = std::max(boundingWidth, x + tile.getTotalWidth());
-                tile.positionX = x; // Record the position of the free tile
-                placedTiles.push_back(tile);
-                return true;
-            }
+// Places one tile read from an input file; max_width tracks the widest tile so far
+void placeLoadedTile(DoublePacker& packer, const SeparationRule& rule, bool ifInter,
+                     const std::vector<TilePart>& parts, int& max_width) {
+    for (const auto& part : parts) {
+        if (part.width > max_width){
+            max_width = part.width;
         }
-        return false;
     }
-
-    bool placeInterTile(const std::vector<TilePart>& parts, int max_width) {
-        Tile tile(parts);
+    TileView tile(parts);
+    if (ifInter) {
         tile.isInter = true;
-        if (if_double){
-            tile.separation = min_separation;
-        }else{
-            if(max_width > min_separation){
-                tile.separation = max_width;
-            } else{
-                tile.separation = min_separation;
-            }
-            if(max_width < 8 & !if_double & tile.separation<min_separation){
-                tile.separation = 8;
-            }
-            
-        }
-        
-        for (int x = 0; x <= MAX_WIDTH - (tile.getTotalWidth() + tile.separation); ++x) {
-            if (inter_fits(x, tile)) {
-                inter_occupied(x, tile);
-                boundingWidth = std::max(boundingWidth, x + tile.getTotalWidth()+tile.separation);
-                tile.positionX = x; // Record the position of the free tile
-                placedTiles.push_back(tile);
-                return true;
-            }
-        }
-        return false;
+        tile.separation = rule.separation(max_width);
     }
-
-    void loadTiles(const std::string& filename) {
-        std::ifstream file(filename);
-        if (!file) {
-            std::cerr << "Failed to open free tiles file: " << filename << "\n";
-            return;
-        }
-        int max_width = 0;
-        std::string line;
-        int count = 0;
-        while (std::getline(file, line)) {
-            if (line.empty()) continue;
-
-            // First line: intraTile or interTile
-            bool ifInter = false;
-            if (line == "interTile") {
-                ifInter = true;
-                count ++;
-            } else if (line == "intraTile") {
-                ifInter = false;
-                count ++;
-            } else {
-                std::cerr << "Unknown tile type: " << line << "\n";
-                continue;
-            }
-
-            // Next line contains the part data
-            if (!std::getline(file, line)) {
-                std::cerr << "Unexpected end of file after part count\n";
-                break;
-            }
-
-            std::istringstream partIss(line);
-            int w, h, dx, dy;
-
-            if (partIss >> w >> h >> dx >> dy) {
-                if (w > max_width){
-                    max_width = w;
-                }
-                std::vector<TilePart> parts;
-                parts.emplace_back(w, h, dx, dy);
-                if(!ifInter){
-                    if (!placeIntraTile(parts)) {
-                        std::cerr << "Failed to place intra tile: ";
-                        for (const auto& part : parts) {
-                            std::cerr << part.width << "x" << part.height << " ";
-                        }
-                        std::cerr << "\n";
-                    }
-                } else {
-                    int cur_width = 0;
-                    if (if_double){
-                        cur_width = min_separation;
-                    }else{
-                        cur_width = max_width;
-                    }
-                    if (!placeInterTile(parts, cur_width)) {
-                        std::cerr << "Failed to place inter tile: ";
-                        for (const auto& part : parts) {
-                            std::cerr << part.width << "x" << part.height << " ";
-                        }
-                        std::cerr << "\n";
-                    }
-                }
-                
-            } else {
-                std::cerr << "Invalid tile part format: " << line << "\n";
-            }
-        }
-        std::cout<<"read tiles:"<<count<<std::endl;
-    }
-
-    void visualize(int maxRows = 20, int maxCols = 80) const {
-        std::cout << "Packing visualization (" << boundingWidth << "x" << boundingHeight << "):\n";
-        int rowsToShow = std::min(boundingHeight, maxRows);
-        int colsToShow = std::min(boundingWidth, maxCols);
-
-        for (int y = 0; y < rowsToShow; ++y) {
-            for (int x = 0; x < colsToShow; ++x) {
-                std::cout << (intra_grid[y][x] ? '#' : '.');
-            }
-            std::cout << "\n";
-        }
-    }
-
-    void exportResults(const std::string& filename) const {
-        std::ofstream out(filename);
-
-        if (!out) {
-            std::cerr << "Failed to open output file: " << filename << "\n";
-            return;
-        }
-
-        out << "Bounding Width: " << boundingWidth << "\n";
-        out << "Bounding Height: " << boundingHeight << "\n";
-        
-        // Export preplaced tiles
-        for (const auto& tile : placedTiles) {
-            out << "Placed " << tile.positionX << " ";
-            for (const auto& part : tile.parts) {
-                out << part.width << " " << part.height << " "
-                    << part.offsetX << " " << part.offsetY << " ";
-            }
-            out << "\n";
-        }
+    if (packer.placeTile(tile) == -1) {
+        reportUnplaced(ifInter ? "inter" : "intra", parts);
     }
+}
 
-};
+// Calls onTile(ifInter, parts) for every tile of an inter/intra input file;
+// in a binary .tpk input TILE_INTER marks the inter tiles
+template <typename OnTile>
+void readInterIntraTiles(const std::string& filename, OnTile&& onTile) {
+    withTileArrays(filename, readInterIntra, [&](const auto& view) {
+        std::vector<TilePart> parts;
+        for (size_t i = 0; i < view.tileCount(); ++i) {
+            readTileParts(view, i, parts);
+            onTile((view.flags[i] & TILE_INTER) != 0, parts);
+        }
+        std::cout<<"read tiles:"<<view.tileCount()<<std::endl;
+    });
+}
 
-#include <iostream>
-#include <fstream>
-#include <string>
+void loadTiles(DoublePacker& packer, const SeparationRule& rule, const std::string& filename) {
+    PackPhase phase(PHASE_LOAD);
+    int max_width = 0;
+    readInterIntraTiles(filename, [&](bool ifInter, const std::vector<TilePart>& parts) {
+        placeLoadedTile(packer, rule, ifInter, parts, max_width);
+    });
+}
 
 std::pair<int, bool> readSeparationAndFlag(const std::string& filename) {
     std::ifstream file(filename);
@@ -333,21 +88,110 @@ std::pair<int, bool> readSeparationAndFlag(const std::string& filename) {
 }
 
 
-int main() {
-    TilePacker packer;
-    const char* separation_file = "C:\\Users\\24835\\Desktop\\homework\\uiuc\\Covey\\chem\\H-chain\\src\\double_packing\\tiles\\separation.txt";
+const char* separation_file = "C:\\Users\\24835\\Desktop\\homework\\uiuc\\Covey\\chem\\H-chain\\src\\double_packing\\tiles\\separation.txt";
+const char* first_tiles = "C:\\Users\\24835\\Desktop\\homework\\uiuc\\Covey\\chem\\H-chain\\src\\double_packing\\tiles\\inter_intra_tiles.txt";
+const char* second_tiles = "C:\\Users\\24835\\Desktop\\homework\\uiuc\\Covey\\chem\\H-chain\\src\\double_packing\\tiles\\second_input_tiles.txt";
+const char* first_result = "C:\\Users\\24835\\Desktop\\homework\\uiuc\\Covey\\chem\\H-chain\\src\\double_packing\\tiles\\result_tiles.txt";
+const char* second_result = "C:\\Users\\24835\\Desktop\\homework\\uiuc\\Covey\\chem\\H-chain\\src\\double_packing\\tiles\\second_result_tiles.txt";
+
+// One pass over tiles already in memory, as loadTiles would place them
+DoublePacker packPass(const std::vector<Tile>& tiles, const SeparationRule& rule) {
+    DoublePacker packer(makeDefaultGrid());
+    int max_width = 0;
+    for (const auto& tile : tiles) {
+        placeLoadedTile(packer, rule, tile.isInter, tile.parts, max_width);
+    }
+    return packer;
+}
+
+// Input of the second pass: the first pass's tiles ordered by placed x, then
+// by height and offsetY (sort_key in double_pack_with_c)
+std::vector<Tile> secondPassTiles(const PlacedTileList& placed) {
+    std::vector<Tile> tiles(placed.begin(), placed.end());
+    std::stable_sort(tiles.begin(), tiles.end(), [](const Tile& a, const Tile& b) {
+        const TilePart& pa = a.parts.front();
+        const TilePart& pb = b.parts.front();
+        if (a.positionX != b.positionX) return a.positionX < b.positionX;
+        if (pa.height != pb.height) return pa.height < pb.height;
+        return pa.offsetY < pb.offsetY;
+    });
+    return tiles;
+}
+
+// Both passes of double_pack_with_c in one run, for every separation given,
+// without writing second_input_tiles.txt or separation.txt in between. The
+// results of the separation with the narrowest second pass are exported.
+int runTwoPass(std::vector<int> separations) {
+    std::vector<Tile> tiles;
+    {
+        PackPhase phase(PHASE_LOAD);
+        readInterIntraTiles(first_tiles, [&tiles](bool ifInter, const std::vector<TilePart>& parts) {
+            tiles.emplace_back(parts);
+            tiles.back().isInter = ifInter;
+        });
+    }
+
+    std::optional<std::pair<DoublePacker, DoublePacker>> best;
+    int bestSeparation = 0;
+    for (int min_separation : separations) {
+        min_separation = std::max(min_separation, 0);
+        DoublePacker first = packPass(tiles, SeparationRule{min_separation, false});
+        DoublePacker second = packPass(secondPassTiles(first.getPlacedTiles()), SeparationRule{min_separation, true});
+        std::cout << "separation " << min_separation << ": first pass " << first.getBoundingWidth()
+                  << ", second pass " << second.getBoundingWidth() << std::endl;
+
+        if (!best || second.getBoundingWidth() < best->second.getBoundingWidth()) {
+            best.emplace(std::move(first), std::move(second));
+            bestSeparation = min_separation;
+        }
+    }
+    if (!best) {
+        return -1;
+    }
+
+    std::cout << "best separation is " << bestSeparation << std::endl;
+    printLowerBounds(best->second.getBoundingWidth(), best->second.lowerBounds());
+    best->first.exportResults(first_result);
+    best->second.exportResults(second_result);
+    exportPackStats(second_result);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    // double_packing --two-pass S [S ...]: both passes for each separation S,
+    // or for the one in separation.txt when none is given
+    if (argc > 1 && std::string(argv[1]) == "--two-pass") {
+        std::vector<int> separations;
+        for (int i = 2; i < argc; ++i) {
+            TextCursor arg(argv[i]);
+            int separation;
+            if (!arg.readInt(separation) || !arg.atEnd() || separation < 0) {
+                std::cerr << "Usage: double_packing [--two-pass [separation ...]]"
+                             " (separations are non-negative integers)\n";
+                return -1;
+            }
+            separations.push_back(separation);
+        }
+        if (separations.empty()) {
+            separations.push_back(readSeparationAndFlag(separation_file).first);
+        }
+        return runTwoPass(separations);
+    }
+
+    DoublePacker packer(makeDefaultGrid());
     auto [min_separation, if_double] = readSeparationAndFlag(separation_file);
     std::cout<<"separation is "<< min_separation << std::endl;
     std::cout<<"double_packed is "<< if_double << std::endl;
-    packer.setDouble(if_double);
-    packer.setSeparation(min_separation);
+    if (min_separation < 0) {
+        std::cerr << "Separation must be non-negative.\n";
+        min_separation = 0;
+    }
+    SeparationRule rule{min_separation, if_double};
     // Load intra tiles (format: Position_x, width, height, dx, dy)
     if (!if_double){
-        const char* tiles = "C:\\Users\\24835\\Desktop\\homework\\uiuc\\Covey\\chem\\H-chain\\src\\double_packing\\tiles\\inter_intra_tiles.txt";
-        packer.loadTiles(tiles);
+        loadTiles(packer, rule, first_tiles);
     }else{
-        const char* tiles = "C:\\Users\\24835\\Desktop\\homework\\uiuc\\Covey\\chem\\H-chain\\src\\double_packing\\tiles\\second_input_tiles.txt";
-        packer.loadTiles(tiles);
+        loadTiles(packer, rule, second_tiles);
     }
     
 
@@ -355,13 +199,15 @@ int main() {
     // Visualize the packing (showing first 20 rows and 80 columns)
     // packer.visualize();
 
+    printLowerBounds(packer.getBoundingWidth(), packer.lowerBounds());
+
     // Export results
     if(!if_double){
-        const char* result_tiles = "C:\\Users\\24835\\Desktop\\homework\\uiuc\\Covey\\chem\\H-chain\\src\\double_packing\\tiles\\result_tiles.txt";
-        packer.exportResults(result_tiles);
+        packer.exportResults(first_result);
+        exportPackStats(first_result);
     }else{
-        const char* result_tiles = "C:\\Users\\24835\\Desktop\\homework\\uiuc\\Covey\\chem\\H-chain\\src\\double_packing\\tiles\\second_result_tiles.txt";
-        packer.exportResults(result_tiles);
+        packer.exportResults(second_result);
+        exportPackStats(second_result);
     }
     
 
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <numeric>
+#include <vector>
+#include "tile_packing.h"
+
+// Bounding widths for a list of gradient thresholds without packing each
+// threshold from scratch. Every tile carries the gradient of the excitation
+// it came from; the tile set for threshold t is { tiles with |gradient| > t }
+// taken in one shared order, exactly what create_excitation followed by
+// create_circuit_tile produces. Sets for larger thresholds are subsets of the
+// sets for smaller ones, and first-fit is online, so two sets pack
+// identically up to the first tile that only one of them contains. The sweep
+// packs the smallest set first, snapshots the packer where the next larger
+// set diverges, and resumes from the snapshot instead of from tile 0. When the
+// order is by decreasing |gradient| every set is a prefix of the next and the
+// whole sweep costs one packing pass.
+
+// Returns the bounding width for each threshold, in the order given, or -1
+// where a tile did not fit.
+inline std::vector<int> sweepEpsilons(const std::vector<Tile>& tiles, const std::vector<double>& gradients,
+                                      const std::vector<double>& thresholds, bool orderByGradient) {
+    using Packer = TilePacker<DefaultGrid>;
+    const int n = static_cast<int>(tiles.size());
+    const int k = static_cast<int>(thresholds.size());
+    std::vector<int> widths(k, 0);
+    if (k == 0) return widths;
+
+    std::vector<int> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    if (orderByGradient) {
+        std::stable_sort(order.begin(), order.end(), [&gradients](int a, int b) {
+            return std::fabs(gradients[a]) > std::fabs(gradients[b]);
+        });
+    }
+
+    // Thresholds ascending; set i (1-based) holds the tiles with level >= i,
+    // where a tile's level is the number of thresholds its |gradient| exceeds
+    std::vector<int> byThreshold(k);
+    std::iota(byThreshold.begin(), byThreshold.end(), 0);
+    std::stable_sort(byThreshold.begin(), byThreshold.end(),
+                     [&thresholds](int a, int b) { return thresholds[a] < thresholds[b]; });
+    std::vector<double> sorted(k);
+    for (int i = 0; i < k; ++i) sorted[i] = thresholds[byThreshold[i]];
+
+    std::vector<int> level(n);
+    for (int q = 0; q < n; ++q) {
+        double g = std::fabs(gradients[order[q]]);
+        level[q] = static_cast<int>(std::lower_bound(sorted.begin(), sorted.end(), g) - sorted.begin());
+    }
+
+    // diverge[i]: first position holding a tile of level exactly i, where set i
+    // stops matching set i + 1 (n if it never does). Set k is packed from 0.
+    std::vector<int> diverge(k + 1, n);
+    for (int q = n - 1; q >= 0; --q) {
+        if (level[q] >= 1 && level[q] < k) diverge[level[q]] = q;
+    }
+    diverge[k] = 0;
+
+    // Set i resumes from set source[i]'s state at diverge[i]: the nearest larger
+    // index whose own run started at or before that position. The sets in
+    // between diverge later, so their state there is the same.
+    std::vector<int> source(k + 1, 0);
+    std::vector<std::vector<int>> snapshotsFor(k + 1);
+    for (int i = 1; i < k; ++i) {
+        int j = i + 1;
+        while (diverge[j] > diverge[i]) ++j;
+        source[i] = j;
+        snapshotsFor[j].push_back(i);
+    }
+
+    // Keyed by the set that will resume from it; the flag records whether
+    // every tile before the snapshot fitted
+    std::map<int, std::pair<Packer, bool>> snapshots;
+    for (int i = k; i >= 1; --i) {
+        Packer packer({}, makeDefaultGrid());
+        bool fitted = true;
+        if (i < k) {
+            packer = std::move(snapshots.at(i).first);
+            fitted = snapshots.at(i).second;
+            snapshots.erase(i);
+        }
+
+        auto takeSnapshots = [&](int q) {
+            for (int waiting : snapshotsFor[i]) {
+                if (diverge[waiting] == q) snapshots.emplace(waiting, std::make_pair(packer, fitted));
+            }
+        };
+
+        for (int q = diverge[i]; q < n; ++q) {
+            takeSnapshots(q);
+            if (fitted && level[q] >= i && !packer.addTile(tiles[order[q]])) {
+                fitted = false;
+            }
+        }
+        takeSnapshots(n);
+        widths[byThreshold[i - 1]] = fitted ? packer.getBoundingWidth() : -1;
+    }
+    return widths;
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <numeric>
+#include <random>
+#include <vector>
+#include "tile_packing.h"
+
+// Simulated annealing over the packing order. A move changes the order from
+// some position p onwards (a swap of two tiles or a block of tiles moved
+// elsewhere); only tiles p.. are packed again, starting from the packer
+// snapshot saved at the last checkpoint before p. Checkpoints are kept every
+// `checkpointInterval` tiles and refreshed when a move is accepted.
+//
+// The acceptance threshold is drawn before the repack, so a candidate is
+// dropped as soon as its partial bounding width passes it.
+
+struct AnnealOptions {
+    double seconds = 1.0;            // Time budget
+    unsigned seed = 0;
+    double startTemperature = 0;     // Width units; 0 = 0.2% of the initial width
+    double endTemperature = 0.05;
+    int checkpointInterval = 0;      // Tiles between snapshots; 0 = about sqrt(tile count)
+    int targetWidth = 0;             // Stop once the best width is at most this, e.g. a lower bound
+    // Called with the elapsed seconds and width whenever the best width improves
+    std::function<void(double, int)> onImprovement;
+};
+
+struct AnnealResult {
+    int initialWidth = -1;   // Width of the starting order, -1 if it does not fit
+    int width = -1;          // Best width found
+    std::vector<int> order;  // Order that produced it, as indices into tiles
+    long moves = 0;
+    long accepted = 0;
+};
+
+template <typename Grid>
+class OrderAnnealer {
+private:
+    using Packer = TilePacker<Grid>;
+    using Snapshot = typename Packer::Snapshot;
+
+    const std::vector<Tile>& tiles;
+    int interval;
+
+    Packer packer;
+    std::vector<int> order;
+    std::vector<Snapshot> checkpoints;  // checkpoints[c] has order[0 .. c * interval) packed
+    int width = -1;
+
+    // Packs candidate[from ..] after restoring the last checkpoint at or
+    // before from, storing the checkpoints it passes in `saved`. Gives up and
+    // returns -1 once the width exceeds `limit` or a tile does not fit.
+    int repack(const std::vector<int>& candidate, int from, int limit, std::vector<Snapshot>& saved) {
+        int c = from / interval;
+        packer.restore(checkpoints[c]);
+        for (int i = c * interval; i < static_cast<int>(candidate.size()); ++i) {
+            if (i > c * interval && i % interval == 0) {
+                saved.push_back(packer.snapshot());
+            }
+            if (!packer.addTile(tiles[candidate[i]]) || packer.getBoundingWidth() > limit) {
+                return -1;
+            }
+        }
+        return packer.getBoundingWidth();
+    }
+
+public:
+    OrderAnnealer(const std::vector<Tile>& t, std::vector<int> start, Grid g, int checkpointInterval)
+        : tiles(t), packer(std::move(g)), order(std::move(start)) {
+        interval = checkpointInterval > 0
+            ? checkpointInterval
+            : std::max(1, static_cast<int>(std::sqrt(static_cast<double>(order.size()))));
+
+        checkpoints.push_back(packer.snapshot());
+        std::vector<Snapshot> saved;
+        width = repack(order, 0, MAX_WIDTH, saved);
+        checkpoints.insert(checkpoints.end(), saved.begin(), saved.end());
+    }
+
+    int currentWidth() const { return width; }
+    const std::vector<int>& currentOrder() const { return order; }
+
+    // Proposes one random move and applies it if its width is at most `limit`
+    bool tryMove(std::mt19937& rng, int limit) {
+        const int n = static_cast<int>(order.size());
+        if (n < 2) return false;
+
+        std::vector<int> candidate = order;
+        int from;
+        if (rng() % 2 == 0) {
+            // Swap two tiles
+            int i = static_cast<int>(rng() % n), j = static_cast<int>(rng() % n);
+            if (i == j) return false;
+            std::swap(candidate[i], candidate[j]);
+            from = std::min(i, j);
+        } else {
+            // Move a block of up to 8 tiles to another position
+            int len = 1 + static_cast<int>(rng() % std::min(8, n - 1));
+            int i = static_cast<int>(rng() % (n - len + 1));
+            int k = static_cast<int>(rng() % (n - len + 1));
+            if (i == k) return false;
+            if (k < i) {
+                std::rotate(candidate.begin() + k, candidate.begin() + i, candidate.begin() + i + len);
+            } else {
+                std::rotate(candidate.begin() + i, candidate.begin() + i + len, candidate.begin() + k + len);
+            }
+            from = std::min(i, k);
+        }
+
+        std::vector<Snapshot> saved;
+        int candidateWidth = repack(candidate, from, limit, saved);
+        if (candidateWidth == -1) {
+            return false;
+        }
+
+        order = std::move(candidate);
+        width = candidateWidth;
+        int c = from / interval;
+        checkpoints.erase(checkpoints.begin() + c + 1, checkpoints.end());
+        checkpoints.insert(checkpoints.end(), saved.begin(), saved.end());
+        return true;
+    }
+};
+
+// Anneals `start` (indices into tiles) for options.seconds on a copy of `grid`.
+// Returns the best order seen; if the starting order does not fit, the result
+// has width -1 and the starting order.
+template <typename Grid>
+AnnealResult annealOrder(const std::vector<Tile>& tiles, std::vector<int> start, Grid grid,
+                         const AnnealOptions& options = AnnealOptions()) {
+    using Clock = std::chrono::steady_clock;
+    const auto begin = Clock::now();
+
+    AnnealResult result;
+    OrderAnnealer<Grid> annealer(tiles, std::move(start), std::move(grid), options.checkpointInterval);
+    result.initialWidth = result.width = annealer.currentWidth();
+    result.order = annealer.currentOrder();
+    if (result.width == -1 || tiles.size() < 2) {
+        return result;
+    }
+
+    const double t0 = options.startTemperature > 0 ? options.startTemperature : std::max(1.0, 0.002 * result.width);
+    const double t1 = std::min(options.endTemperature, t0);
+    std::mt19937 rng(options.seed);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+    while (result.width > options.targetWidth) {
+        double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+        if (elapsed >= options.seconds) break;
+
+        // Metropolis: accept a width increase d with probability exp(-d / T),
+        // i.e. accept iff d <= -T ln u for a u drawn up front
+        double temperature = t0 * std::pow(t1 / t0, elapsed / options.seconds);
+        double slack = -temperature * std::log(1.0 - uniform(rng));
+        int limit = annealer.currentWidth() + static_cast<int>(std::min(slack, static_cast<double>(MAX_WIDTH)));
+
+        ++result.moves;
+        if (!annealer.tryMove(rng, limit)) continue;
+        ++result.accepted;
+
+        if (annealer.currentWidth() < result.width) {
+            result.width = annealer.currentWidth();
+            result.order = annealer.currentOrder();
+            if (options.onImprovement) {
+                options.onImprovement(elapsed, result.width);
+            }
+        }
+    }
+    return result;
+}
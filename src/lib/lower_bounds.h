@@ -0,0 +1,200 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include <vector>
+#include "tile.h"
+
+// Lower bounds on the bounding width any packing order can reach. All are
+// linear or n log n in the number of parts, cheap enough to report with every
+// export and to stop an order search once the width is within tolerance.
+//
+// Each tile contributes by kind: preplaced tiles at their positionX, inter
+// tiles with their separation (double packing), everything else as a free
+// tile.
+struct WidthBounds {
+    // Busiest row: total width of the parts covering it. Parts on a row are
+    // pairwise disjoint, and by the Helly property of intervals this is also
+    // the heaviest clique of parts whose row spans overlap.
+    int rowLoad = 0;
+    // Every tile lies inside the packing, gaps between its parts included
+    int widestTile = 0;
+    // Double packing: on each row, the inter tiles' parts widened by their
+    // separation are disjoint and end inside the packing
+    int separation = 0;
+    // Preplaced tiles are fixed: a row's free load has to fit in the columns
+    // they leave free, and the packing extends at least to their right edge
+    int preplaced = 0;
+
+    int best() const { return std::max({rowLoad, widestTile, separation, preplaced}); }
+};
+
+// Total length of the union of [start, end) intervals
+inline int unionLength(std::vector<std::pair<int, int>>& intervals) {
+    std::sort(intervals.begin(), intervals.end());
+    int total = 0, cursor = 0;
+    for (const auto& [start, end] : intervals) {
+        int from = std::max(start, cursor);
+        if (end > from) {
+            total += end - from;
+            cursor = end;
+        }
+    }
+    return total;
+}
+
+// Smallest width whose row, with the given occupied intervals, has `load`
+// free columns
+inline int widthForLoad(std::vector<std::pair<int, int>>& occupied, int load) {
+    if (load <= 0) return 0;
+    std::sort(occupied.begin(), occupied.end());
+    int free = 0, cursor = 0;
+    for (const auto& [start, end] : occupied) {
+        if (start > cursor) {
+            if (free + (start - cursor) >= load) {
+                return cursor + (load - free);
+            }
+            free += start - cursor;
+        }
+        cursor = std::max(cursor, end);
+    }
+    return cursor + (load - free);
+}
+
+// Adds, for every row the tile covers, the length its parts cover on that
+// row (each widened by `widen`) to the difference array `rows`. Parts of one
+// tile may overlap, so rows with several parts count their union.
+inline void addRowCoverage(const TileView& tile, int widen, std::vector<long long>& rows) {
+    if (tile.parts.size() == 1) {
+        const TilePart& part = tile.parts.front();
+        if (part.width > 0 && part.height > 0) {
+            rows[part.offsetY] += part.width + widen;
+            rows[part.offsetY + part.height] -= part.width + widen;
+        }
+        return;
+    }
+
+    int top = static_cast<int>(rows.size()), bottom = 0;
+    for (const auto& part : tile.parts) {
+        if (part.width <= 0 || part.height <= 0) continue;
+        top = std::min(top, part.offsetY);
+        bottom = std::max(bottom, part.offsetY + part.height);
+    }
+    std::vector<std::pair<int, int>> covered;
+    for (int row = top; row < bottom; ++row) {
+        covered.clear();
+        for (const auto& part : tile.parts) {
+            if (part.width > 0 && part.offsetY <= row && row < part.offsetY + part.height) {
+                covered.emplace_back(part.offsetX, part.offsetX + part.width + widen);
+            }
+        }
+        int length = unionLength(covered);
+        rows[row] += length;
+        rows[row + 1] -= length;
+    }
+}
+
+// Tiles may be any range of Tiles or TileViews, e.g. TilePacker::getPlacedTiles()
+template <typename Tiles>
+WidthBounds computeLowerBounds(const Tiles& tiles) {
+    WidthBounds bounds;
+
+    int height = 0;
+    for (const auto& tile : tiles) {
+        height = std::max(height, tile.getTotalHeight());
+    }
+
+    // Per row, as difference arrays: load of all tiles, of the free tiles and
+    // of the widened inter tiles; plus the preplaced intervals
+    std::vector<long long> load(height + 1, 0), freeLoad(height + 1, 0), interLoad(height + 1, 0);
+    std::vector<std::vector<std::pair<int, int>>> preplacedCells(height);
+    bool anyPreplaced = false, anyInter = false;
+
+    for (const auto& tile : tiles) {
+        int right = 0;
+        for (const auto& part : tile.parts) {
+            if (part.width > 0 && part.height > 0) right = std::max(right, part.offsetX + part.width);
+        }
+        bounds.widestTile = std::max(bounds.widestTile, right);
+        addRowCoverage(tile, 0, load);
+
+        if (tile.isPreplaced) {
+            anyPreplaced = true;
+            if (right > 0) bounds.preplaced = std::max(bounds.preplaced, tile.positionX + right);
+            for (const auto& part : tile.parts) {
+                for (int row = part.offsetY; row < part.offsetY + part.height; ++row) {
+                    preplacedCells[row].emplace_back(tile.positionX + part.offsetX,
+                                                     tile.positionX + part.offsetX + part.width);
+                }
+            }
+            continue;
+        }
+
+        addRowCoverage(tile, 0, freeLoad);
+        if (tile.isInter) {
+            anyInter = true;
+            addRowCoverage(tile, tile.separation, interLoad);
+        }
+    }
+
+    long long rowLoad = 0, rowFree = 0, rowInter = 0;
+    for (int row = 0; row < height; ++row) {
+        rowLoad += load[row];
+        rowFree += freeLoad[row];
+        rowInter += interLoad[row];
+        bounds.rowLoad = std::max(bounds.rowLoad, static_cast<int>(rowLoad));
+        if (anyInter) {
+            bounds.separation = std::max(bounds.separation, static_cast<int>(rowInter));
+        }
+        if (anyPreplaced) {
+            bounds.preplaced = std::max(bounds.preplaced,
+                                        widthForLoad(preplacedCells[row], static_cast<int>(rowFree)));
+        }
+    }
+    return bounds;
+}
+
+// Row-load and widest-tile bounds of free tiles added one at a time, for
+// streams whose tiles are never all held at once. Equal to computeLowerBounds
+// over the same tiles when none of them is preplaced or inter.
+class StreamingBounds {
+private:
+    std::vector<long long> load;  // Difference array over the rows
+    int widestTile = 0;
+
+public:
+    void add(const TileView& tile) {
+        int right = 0;
+        for (const auto& part : tile.parts) {
+            if (part.width > 0 && part.height > 0) right = std::max(right, part.offsetX + part.width);
+        }
+        widestTile = std::max(widestTile, right);
+
+        size_t rows = static_cast<size_t>(tile.getTotalHeight()) + 1;
+        if (load.size() < rows) load.resize(rows, 0);
+        addRowCoverage(tile, 0, load);
+    }
+
+    WidthBounds bounds() const {
+        WidthBounds result;
+        result.widestTile = widestTile;
+        long long rowLoad = 0;
+        for (long long delta : load) {
+            rowLoad += delta;
+            result.rowLoad = std::max(result.rowLoad, static_cast<int>(rowLoad));
+        }
+        return result;
+    }
+};
+
+// Prints the bounds and how far `width` is above the best of them
+inline void printLowerBounds(int width, const WidthBounds& bounds, std::ostream& out = std::cout) {
+    int best = bounds.best();
+    out << "Lower bound: " << best
+              << " (row load " << bounds.rowLoad << ", widest tile " << bounds.widestTile
+              << ", separation " << bounds.separation << ", preplaced " << bounds.preplaced << ")\n";
+    if (best > 0) {
+        out << "Gap to lower bound: " << (100.0 * (width - best) / best) << "%\n";
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "tile_packing.h"
+
+// Packing for devices of any number of modules. The seams split the rows into
+// modules; each seam has its own separation and gate time ratio. A tile
+// whose first part spans rows dy .. dy+h is an inter-module tile of every
+// seam with dy < seam <= dy+h (packed once per seam it crosses, as in
+// split_grid), and an intra-module tile of the module it lies in otherwise.
+//
+// Intra-module tiles of different modules cover disjoint rows and never
+// interact, so every module is packed on its own packer and thread; the
+// results are merged into one packer that then places the inter-module tiles
+// seam by seam, each keeping its seam's separation (see InterSeparation).
+// The placements are those of packing the same order on a single packer.
+
+struct Seam {
+    int row;             // First row of the module above the seam
+    int separation = 0;  // Free columns inter tiles of this seam keep to their right
+    int ratio = 1;       // Inter/intra gate time ratio; widens the tiles by 2 * (ratio - 1)
+};
+
+struct ModuleTiles {
+    std::vector<std::vector<Tile>> intra;  // Per module, bottom to top: seams.size() + 1 of them
+    std::vector<std::vector<Tile>> inter;  // Per seam, in the order of the seams
+};
+
+// Splits the tiles at the seams, which must be sorted by row. Every group
+// keeps the order of `tiles`, optionally stable-sorted by total area
+// (largest first).
+inline ModuleTiles splitModules(const std::vector<Tile>& tiles, const std::vector<Seam>& seams, bool sortByArea) {
+    ModuleTiles split;
+    split.intra.resize(seams.size() + 1);
+    split.inter.resize(seams.size());
+
+    for (const auto& tile : tiles) {
+        if (tile.parts.empty()) continue;
+        const TilePart& first = tile.parts.front();
+
+        size_t module = 0;
+        bool crossed = false;
+        for (size_t s = 0; s < seams.size(); ++s) {
+            if (first.offsetY < seams[s].row && first.offsetY + first.height >= seams[s].row) {
+                Tile inter = tile;
+                inter.isInter = true;
+                inter.separation = seams[s].separation;
+                inter.parts.front().width += 2 * (seams[s].ratio - 1);
+                split.inter[s].push_back(std::move(inter));
+                crossed = true;
+            } else if (seams[s].row <= first.offsetY) {
+                module = s + 1;
+            }
+        }
+        if (!crossed) {
+            split.intra[module].push_back(tile);
+            split.intra[module].back().isInter = false;
+            split.intra[module].back().separation = 0;
+        }
+    }
+
+    if (sortByArea) {
+        auto area = [](const Tile& tile) {
+            int total = 0;
+            for (const auto& part : tile.parts) total += part.width * part.height;
+            return total;
+        };
+        auto byArea = [&area](const Tile& a, const Tile& b) { return area(a) > area(b); };
+        for (auto& group : split.intra) std::stable_sort(group.begin(), group.end(), byArea);
+        for (auto& group : split.inter) std::stable_sort(group.begin(), group.end(), byArea);
+    }
+    return split;
+}
+
+using ModulePacker = TilePacker<DefaultGrid, FirstFit, InterSeparation>;
+
+struct ModulePacking {
+    ModulePacker packer{makeDefaultGrid()};  // Every module and seam, merged
+    std::vector<int> moduleWidths;           // Width of each module's intra tiles alone
+    bool complete = true;                    // False if a tile did not fit
+};
+
+// Packs the intra-module tiles of the modules on `threads` worker threads
+// (0 = one per core), then the inter-module tiles of every seam in turn
+inline ModulePacking packModules(const std::vector<Tile>& tiles, std::vector<Seam> seams, bool sortByArea,
+                                 int threads = 0) {
+    std::stable_sort(seams.begin(), seams.end(), [](const Seam& a, const Seam& b) { return a.row < b.row; });
+    ModuleTiles split = splitModules(tiles, seams, sortByArea);
+
+    const size_t moduleCount = split.intra.size();
+    std::vector<TilePacker<DefaultGrid>> modules;
+    modules.reserve(moduleCount);
+    for (auto& group : split.intra) {
+        modules.emplace_back(group, makeDefaultGrid());
+    }
+
+    ModulePacking result;
+    std::vector<char> packed(moduleCount, 0);
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t module = next++; module < moduleCount; module = next++) {
+            packed[module] = modules[module].packTiles();
+        }
+    };
+
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threads = static_cast<int>(std::min<size_t>(threads, moduleCount));
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    for (size_t module = 0; module < moduleCount; ++module) {
+        result.complete = result.complete && packed[module];
+        result.moduleWidths.push_back(modules[module].getBoundingWidth());
+        for (const auto& tile : modules[module].getPlacedTiles()) {
+            result.packer.addPlacedTile(tile.positionX, tile);
+        }
+    }
+
+    for (const auto& group : split.inter) {
+        for (const auto& tile : group) {
+            if (result.packer.placeTile(tile) == -1) {
+                result.complete = false;
+            }
+        }
+    }
+    return result;
+}
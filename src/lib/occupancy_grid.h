@@ -0,0 +1,540 @@
+#pragma once
+
+#include <vector>
+#include <map>
+#include <iterator>
+#include <algorithm>
+#include <cstdint>
+#include "pack_stats.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Occupancy grids used by the packers. Every grid answers the same questions
+// about a rectangle of cells (columns x .. x+w-1, rows y .. y+h-1):
+//   isFree(x, y, w, h)            - true if none of the cells is occupied
+//   rightmostOccupied(x, y, w, h) - largest occupied column in the rectangle, or -1
+//   nextFit(x, y, w, h, limit)    - smallest x' >= x where the rectangle is free,
+//                                   or some value >= limit if there is none below it
+//   occupy(x, y, w, h)            - mark all of the cells as occupied
+//   release(x, y, w, h)           - mark all of the cells as free again
+//   clear()                       - mark every cell free again
+// plus occupied(row, col) for the text visualizations and the first-free hints.
+
+// nextFit for grids without a free-run index: keep jumping one past the
+// rightmost occupied column until the rectangle is clear.
+template <typename Grid>
+int scanNextFit(const Grid& grid, int x, int y, int w, int h, int limit) {
+    int blocked;
+    while (x < limit && (blocked = grid.rightmostOccupied(x, y, w, h)) >= 0) {
+        x = blocked + 1;
+    }
+    return x;
+}
+
+// Dense row-major grid, one Cell per cell. Memory is height * width cells
+// regardless of how many tiles are placed.
+template <typename Cell = int>
+class DenseGrid {
+private:
+    std::vector<std::vector<Cell>> cells;
+
+public:
+    DenseGrid(int height, int width) : cells(height, std::vector<Cell>(width, 0)) {}
+
+    bool isFree(int x, int y, int w, int h) const {
+        for (int row = y; row < y + h; ++row) {
+            for (int col = x; col < x + w; ++col) {
+                PACK_STATS_ADD(probes, 1);
+                if (cells[row][col] == 1) {  // Space is occupied
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    int rightmostOccupied(int x, int y, int w, int h) const {
+        int rightmost = -1;
+        for (int row = y; row < y + h; ++row) {
+            // Columns at or left of the current answer cannot improve it
+            for (int col = x + w - 1; col > std::max(x - 1, rightmost); --col) {
+                PACK_STATS_ADD(probes, 1);
+                if (cells[row][col] == 1) {
+                    rightmost = col;
+                    break;
+                }
+            }
+        }
+        return rightmost;
+    }
+
+    int nextFit(int x, int y, int w, int h, int limit) const {
+        return scanNextFit(*this, x, y, w, h, limit);
+    }
+
+    void occupy(int x, int y, int w, int h) {
+        for (int row = y; row < y + h; ++row) {
+            for (int col = x; col < x + w; ++col) {
+                cells[row][col] = 1;  // Mark the space as occupied
+            }
+        }
+    }
+
+    void release(int x, int y, int w, int h) {
+        for (int row = y; row < y + h; ++row) {
+            std::fill(cells[row].begin() + x, cells[row].begin() + x + w, 0);
+        }
+    }
+
+    bool occupied(int row, int col) const {
+        return cells[row][col] == 1;
+    }
+
+    void clear() {
+        for (auto& row : cells) {
+            std::fill(row.begin(), row.end(), 0);
+        }
+    }
+};
+
+// Sparse grid keeping, per row, the occupied cells as disjoint [start, end)
+// column intervals keyed by start. Touching intervals are merged on insert,
+// so memory scales with the number of placed tiles rather than the width.
+class IntervalGrid {
+private:
+    std::vector<std::map<int, int>> rows;
+
+    // True if [x, x + w) does not intersect any interval in the row
+    bool rowIsFree(const std::map<int, int>& intervals, int x, int w) const {
+        if (w <= 0) return true;
+        auto next = intervals.upper_bound(x);
+        if (next != intervals.end() && next->first < x + w) {
+            return false;  // An interval starts inside the range
+        }
+        if (next != intervals.begin() && std::prev(next)->second > x) {
+            return false;  // An interval starting at or before x reaches into the range
+        }
+        return true;
+    }
+
+    void rowOccupy(std::map<int, int>& intervals, int x, int w) {
+        if (w <= 0) return;
+        int start = x;
+        int end = x + w;
+
+        // Absorb a preceding interval that touches or overlaps the new one
+        auto it = intervals.upper_bound(start);
+        if (it != intervals.begin()) {
+            auto prev = std::prev(it);
+            if (prev->second >= start) {
+                start = prev->first;
+                end = std::max(end, prev->second);
+                it = intervals.erase(prev);
+            }
+        }
+
+        // Absorb following intervals that start before the new end
+        while (it != intervals.end() && it->first <= end) {
+            end = std::max(end, it->second);
+            it = intervals.erase(it);
+        }
+
+        intervals.emplace_hint(it, start, end);
+    }
+
+    void rowRelease(std::map<int, int>& intervals, int x, int w) {
+        if (w <= 0) return;
+        int end = x + w;
+
+        // Split an interval starting before x that reaches into the range
+        auto it = intervals.lower_bound(x);
+        if (it != intervals.begin()) {
+            auto prev = std::prev(it);
+            if (prev->second > x) {
+                int prevEnd = prev->second;
+                prev->second = x;
+                if (prevEnd > end) {
+                    intervals.emplace_hint(it, end, prevEnd);
+                    return;
+                }
+            }
+        }
+
+        // Drop intervals starting inside the range, keeping any tail past it
+        while (it != intervals.end() && it->first < end) {
+            int itEnd = it->second;
+            it = intervals.erase(it);
+            if (itEnd > end) {
+                intervals.emplace_hint(it, end, itEnd);
+                break;
+            }
+        }
+    }
+
+public:
+    explicit IntervalGrid(int height) : rows(height) {}
+
+    bool isFree(int x, int y, int w, int h) const {
+        for (int row = y; row < y + h; ++row) {
+            PACK_STATS_ADD(probes, 1);
+            if (!rowIsFree(rows[row], x, w)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int rightmostOccupied(int x, int y, int w, int h) const {
+        int rightmost = -1;
+        if (w <= 0) return rightmost;
+        for (int row = y; row < y + h; ++row) {
+            PACK_STATS_ADD(probes, 1);
+            // Last interval starting before the end of the range
+            auto it = rows[row].lower_bound(x + w);
+            if (it == rows[row].begin()) continue;
+            --it;
+            if (it->second > x) {
+                rightmost = std::max(rightmost, std::min(it->second, x + w) - 1);
+            }
+        }
+        return rightmost;
+    }
+
+    int nextFit(int x, int y, int w, int h, int limit) const {
+        return scanNextFit(*this, x, y, w, h, limit);
+    }
+
+    void occupy(int x, int y, int w, int h) {
+        for (int row = y; row < y + h; ++row) {
+            rowOccupy(rows[row], x, w);
+        }
+    }
+
+    void release(int x, int y, int w, int h) {
+        for (int row = y; row < y + h; ++row) {
+            rowRelease(rows[row], x, w);
+        }
+    }
+
+    bool occupied(int row, int col) const {
+        return !rowIsFree(rows[row], col, 1);
+    }
+
+    void clear() {
+        for (auto& intervals : rows) {
+            intervals.clear();
+        }
+    }
+};
+
+// Column-major bitmask grid: one 64-bit word per column with bit r set when
+// row r is occupied. A rectangle is free when every column word in its range
+// ANDed with the rectangle's row mask is zero, which is tested four columns
+// at a time with AVX2 when available. Only rows 0..63 can be represented;
+// rectangles reaching past row 63 never fit, and only their rows below 64 are
+// recorded when placed anyway (preplaced tiles). Columns are allocated on demand.
+class ColumnMaskGrid {
+private:
+    std::vector<uint64_t> columns;
+
+    static uint64_t rowMask(int y, int h) {
+        uint64_t bits = (h >= 64) ? ~uint64_t(0) : ((uint64_t(1) << h) - 1);
+        return bits << y;
+    }
+
+public:
+    static constexpr int MAX_ROWS = 64;
+
+    ColumnMaskGrid() = default;
+
+    bool isFree(int x, int y, int w, int h) const {
+        if (w <= 0 || h <= 0) return true;
+        if (y + h > MAX_ROWS) return false;
+
+        const uint64_t mask = rowMask(y, h);
+        const int end = std::min<int>(x + w, static_cast<int>(columns.size()));
+        int col = x;
+
+#ifdef __AVX2__
+        const __m256i vmask = _mm256_set1_epi64x(static_cast<long long>(mask));
+        for (; col + 4 <= end; col += 4) {
+            PACK_STATS_ADD(probes, 4);
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&columns[col]));
+            if (!_mm256_testz_si256(v, vmask)) {
+                return false;
+            }
+        }
+#endif
+        for (; col < end; ++col) {
+            PACK_STATS_ADD(probes, 1);
+            if (columns[col] & mask) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Scans from the right so the first hit is the answer. Rectangles reaching
+    // past row 63 report their last column as blocked.
+    int rightmostOccupied(int x, int y, int w, int h) const {
+        if (w <= 0 || h <= 0) return -1;
+        if (y + h > MAX_ROWS) return x + w - 1;
+
+        const uint64_t mask = rowMask(y, h);
+        int col = std::min<int>(x + w, static_cast<int>(columns.size()));
+
+#ifdef __AVX2__
+        const __m256i vmask = _mm256_set1_epi64x(static_cast<long long>(mask));
+        for (; col - 4 >= x; col -= 4) {
+            PACK_STATS_ADD(probes, 4);
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&columns[col - 4]));
+            if (!_mm256_testz_si256(v, vmask)) {
+                break;  // The hit is in columns col-4 .. col-1, found below
+            }
+        }
+#endif
+        for (--col; col >= x; --col) {
+            PACK_STATS_ADD(probes, 1);
+            if (columns[col] & mask) {
+                return col;
+            }
+        }
+        return -1;
+    }
+
+    int nextFit(int x, int y, int w, int h, int limit) const {
+        return scanNextFit(*this, x, y, w, h, limit);
+    }
+
+    // Preplaced tiles are occupied without an isFree check, so rows past 63
+    // are clipped here as in release rather than shifting past the word
+    void occupy(int x, int y, int w, int h) {
+        if (w <= 0 || h <= 0 || y >= MAX_ROWS) return;
+        if (static_cast<int>(columns.size()) < x + w) {
+            columns.resize(x + w, 0);
+        }
+        const uint64_t mask = rowMask(y, std::min(h, MAX_ROWS - y));
+        for (int col = x; col < x + w; ++col) {
+            columns[col] |= mask;
+        }
+    }
+
+    void release(int x, int y, int w, int h) {
+        if (w <= 0 || h <= 0 || y >= MAX_ROWS) return;
+        const uint64_t mask = rowMask(y, std::min(h, MAX_ROWS - y));
+        const int end = std::min<int>(x + w, static_cast<int>(columns.size()));
+        for (int col = x; col < end; ++col) {
+            columns[col] &= ~mask;
+        }
+    }
+
+    bool occupied(int row, int col) const {
+        return row < 64 && col < static_cast<int>(columns.size()) && ((columns[col] >> row) & 1);
+    }
+
+    void clear() {
+        columns.clear();
+    }
+};
+
+// Segment tree over the columns of one row. Each node stores the length of
+// the free run at its left edge (prefix), at its right edge (suffix) and the
+// longest free run inside it (best), so the leftmost free run of a given
+// length is found by a single descent. Columns past the capacity are free;
+// the capacity doubles when a tile is placed beyond it.
+class FreeRunTree {
+private:
+    int capacity = 0;  // Number of leaves, a power of two
+    std::vector<int> prefix, suffix, best;
+
+    void pull(int node, int len) {
+        int half = len / 2;
+        int left = 2 * node, right = 2 * node + 1;
+        prefix[node] = (prefix[left] == half) ? half + prefix[right] : prefix[left];
+        suffix[node] = (suffix[right] == half) ? half + suffix[left] : suffix[right];
+        best[node] = std::max({best[left], best[right], suffix[left] + prefix[right]});
+    }
+
+    void grow(int width) {
+        int newCapacity = std::max(capacity, 64);
+        while (newCapacity < width) newCapacity *= 2;
+
+        std::vector<int> leaves(newCapacity, 1);
+        for (int col = 0; col < capacity; ++col) {
+            leaves[col] = prefix[capacity + col];
+        }
+
+        capacity = newCapacity;
+        prefix.assign(2 * capacity, 0);
+        suffix.assign(2 * capacity, 0);
+        best.assign(2 * capacity, 0);
+        for (int col = 0; col < capacity; ++col) {
+            prefix[capacity + col] = suffix[capacity + col] = best[capacity + col] = leaves[col];
+        }
+        for (int node = capacity - 1, len = 2; node >= 1; --node) {
+            if (node < capacity / len) len *= 2;
+            pull(node, len);
+        }
+    }
+
+    // Sets columns x .. x+w-1 to free (1) or occupied (0) and updates their
+    // ancestors level by level
+    void assign(int x, int w, int free) {
+        int lo = capacity + x, hi = capacity + x + w - 1;
+        for (int leaf = lo; leaf <= hi; ++leaf) {
+            prefix[leaf] = suffix[leaf] = best[leaf] = free;
+        }
+        for (int len = 2; lo > 1; len *= 2) {
+            lo /= 2;
+            hi /= 2;
+            for (int node = lo; node <= hi; ++node) {
+                pull(node, len);
+            }
+        }
+    }
+
+    // Leftmost run of length >= w inside the node, starting with `run` free
+    // columns carried in from the left. The caller guarantees such a run ends
+    // inside the node but does not start in the carried run plus its prefix.
+    int descend(int node, int l, int r, int w, int run) const {
+        int mid = (l + r) / 2;
+        int left = 2 * node, right = 2 * node + 1;
+        if (best[left] >= w) {
+            return descend(left, l, mid, w, run);
+        }
+        int carry = (prefix[left] == mid - l) ? run + (mid - l) : suffix[left];
+        if (carry + prefix[right] >= w) {
+            return mid - carry;
+        }
+        return descend(right, mid, r, w, carry);
+    }
+
+    // Visits the nodes covering [x, capacity) left to right, carrying the
+    // length of the free run that ends at the current node's left edge.
+    int find(int node, int l, int r, int x, int w, int& run) const {
+        if (r <= x) return -1;
+        if (l >= x) {
+            if (run + prefix[node] >= w) return l - run;
+            if (best[node] >= w) return descend(node, l, r, w, run);
+            run = (prefix[node] == r - l) ? run + (r - l) : suffix[node];
+            return -1;
+        }
+        int mid = (l + r) / 2;
+        int found = find(2 * node, l, mid, x, w, run);
+        if (found >= 0) return found;
+        return find(2 * node + 1, mid, r, x, w, run);
+    }
+
+    int rightmostOccupied(int node, int l, int r, int x, int end) const {
+        if (r <= x || l >= end || best[node] == r - l) return -1;  // Outside or all free
+        if (r - l == 1) return l;
+        int mid = (l + r) / 2;
+        int found = rightmostOccupied(2 * node + 1, mid, r, x, end);
+        if (found >= 0) return found;
+        return rightmostOccupied(2 * node, l, mid, x, end);
+    }
+
+public:
+    // Leftmost column s >= x such that columns s .. s+w-1 are all free
+    int nextRun(int x, int w) const {
+        if (w <= 0 || x >= capacity) return x;
+        int run = 0;
+        int found = find(1, 0, capacity, x, w, run);
+        return (found >= 0) ? found : capacity - run;
+    }
+
+    int rightmostOccupied(int x, int w) const {
+        if (w <= 0 || x >= capacity) return -1;
+        return rightmostOccupied(1, 0, capacity, x, std::min(x + w, capacity));
+    }
+
+    bool occupied(int col) const {
+        return col < capacity && prefix[capacity + col] == 0;
+    }
+
+    void occupy(int x, int w) {
+        if (w <= 0) return;
+        if (x + w > capacity) grow(x + w);
+        assign(x, w, 0);
+    }
+
+    // Columns past the capacity are already free
+    void release(int x, int w) {
+        w = std::min(x + w, capacity) - x;
+        if (w <= 0) return;
+        assign(x, w, 1);
+    }
+
+};
+
+// Grid backed by one FreeRunTree per row. nextFit answers "leftmost x where
+// rows y .. y+h-1 all have a free run of length w" with O(log W) descents per
+// row instead of probing candidate columns one at a time.
+class FreeRunGrid {
+private:
+    std::vector<FreeRunTree> rows;
+
+public:
+    explicit FreeRunGrid(int height) : rows(height) {}
+
+    bool isFree(int x, int y, int w, int h) const {
+        for (int row = y; row < y + h; ++row) {
+            PACK_STATS_ADD(probes, 1);
+            if (rows[row].nextRun(x, w) != x) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int rightmostOccupied(int x, int y, int w, int h) const {
+        int rightmost = -1;
+        for (int row = y; row < y + h; ++row) {
+            PACK_STATS_ADD(probes, 1);
+            rightmost = std::max(rightmost, rows[row].rightmostOccupied(x, w));
+        }
+        return rightmost;
+    }
+
+    // Moves x right to each row's next run until a full pass over the rows
+    // leaves it in place
+    int nextFit(int x, int y, int w, int h, int limit) const {
+        bool moved = true;
+        while (moved && x < limit) {
+            moved = false;
+            for (int row = y; row < y + h; ++row) {
+                PACK_STATS_ADD(probes, 1);
+                int start = rows[row].nextRun(x, w);
+                if (start != x) {
+                    x = start;
+                    moved = true;
+                }
+            }
+        }
+        return x;
+    }
+
+    void occupy(int x, int y, int w, int h) {
+        for (int row = y; row < y + h; ++row) {
+            rows[row].occupy(x, w);
+        }
+    }
+
+    void release(int x, int y, int w, int h) {
+        for (int row = y; row < y + h; ++row) {
+            rows[row].release(x, w);
+        }
+    }
+
+    bool occupied(int row, int col) const {
+        return rows[row].occupied(col);
+    }
+
+    void clear() {
+        for (auto& row : rows) {
+            row = FreeRunTree();
+        }
+    }
+};
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+#include "tile_packing.h"
+
+// Multi-start search over packing orders. The bounding width depends heavily
+// on the order tiles are packed in, so instead of a single hand-picked sort
+// (process_tiles, preplace_pack_with_c, the Python TilePacker) every
+// heuristic order below is packed, plus randomized perturbations of them, and
+// the narrowest packing wins.
+
+// Heuristic orders, as indices into tiles. The sort keys mirror the Python
+// heuristics; all sorts are stable so ties keep the input order.
+inline std::vector<std::vector<int>> heuristicOrders(const std::vector<Tile>& tiles) {
+    auto area = [](const Tile& tile) {
+        int total = 0;
+        for (const auto& part : tile.parts) total += part.width * part.height;
+        return total;
+    };
+    auto heightSum = [](const Tile& tile) {
+        int total = 0;
+        for (const auto& part : tile.parts) total += part.height;
+        return total;
+    };
+    // First-part fields, as process_tiles keys on tile[0]
+    auto top = [](const Tile& tile) { return tile.parts.empty() ? 0 : tile.parts.front().offsetY; };
+    auto bottom = [](const Tile& tile) {
+        return tile.parts.empty() ? 0 : tile.parts.front().offsetY + tile.parts.front().height;
+    };
+
+    std::vector<std::function<bool(const Tile&, const Tile&)>> keys = {
+        // Total area, largest first (TilePacker in tile_process.py)
+        [&](const Tile& a, const Tile& b) { return area(a) > area(b); },
+        // Total height, tallest / shortest first (preplace_pack_with_c)
+        [&](const Tile& a, const Tile& b) { return heightSum(a) > heightSum(b); },
+        [&](const Tile& a, const Tile& b) { return heightSum(a) < heightSum(b); },
+        // Bottom edge, lowest first and then tallest (inter_tiles_down)
+        [&](const Tile& a, const Tile& b) {
+            if (bottom(a) != bottom(b)) return bottom(a) > bottom(b);
+            return a.getTotalHeight() > b.getTotalHeight();
+        },
+        // (dy + h) * dy, largest first (intra_tiles_mid)
+        [&](const Tile& a, const Tile& b) { return bottom(a) * top(a) > bottom(b) * top(b); },
+        // Top edge, highest first (intra_tiles_up)
+        [&](const Tile& a, const Tile& b) { return top(a) < top(b); },
+        // Total width, widest first
+        [&](const Tile& a, const Tile& b) { return a.getTotalWidth() > b.getTotalWidth(); },
+    };
+
+    std::vector<int> identity(tiles.size());
+    std::iota(identity.begin(), identity.end(), 0);
+
+    std::vector<std::vector<int>> orders = {identity};
+    for (const auto& key : keys) {
+        std::vector<int> order = identity;
+        std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return key(tiles[a], tiles[b]); });
+        orders.push_back(std::move(order));
+    }
+    return orders;
+}
+
+// Random perturbation of an order: a few swaps between nearby positions, so
+// the order keeps the broad shape of its heuristic
+inline void perturbOrder(std::vector<int>& order, std::mt19937& rng) {
+    const int n = static_cast<int>(order.size());
+    if (n < 2) return;
+
+    const int window = std::min(n - 1, 16);
+    const int swaps = std::max(1, n / 20);
+    for (int s = 0; s < swaps; ++s) {
+        int i = static_cast<int>(rng() % n);
+        int j = std::clamp(i + static_cast<int>(rng() % (2 * window + 1)) - window, 0, n - 1);
+        std::swap(order[i], order[j]);
+    }
+}
+
+struct OrderingResult {
+    int width = -1;          // Best bounding width, -1 if no order fits
+    std::vector<int> order;  // The order that produced it, as indices into tiles
+    int runs = 0;            // Orders packed
+    int abandoned = 0;       // Runs stopped early because they were already wider than the best
+};
+
+// Packs the heuristic orders and `randomStarts` perturbations of them on
+// `threads` worker threads (0 = one per core). Random start i perturbs
+// heuristic i % (number of heuristics) with a generator seeded by seed + i,
+// so the result does not depend on the thread count. A run stops as soon as
+// its partial bounding width exceeds the best width found so far; on ties the
+// lowest-numbered run wins. Once some run reaches targetWidth (e.g. a lower
+// bound) the remaining runs are skipped, which makes the result depend on
+// timing unless targetWidth is 0.
+inline OrderingResult searchOrderings(const std::vector<Tile>& tiles, int randomStarts, unsigned seed,
+                                      int threads = 0, int targetWidth = 0) {
+    OrderingResult result;
+    if (tiles.empty()) {
+        result.width = 0;
+        return result;
+    }
+
+    const std::vector<std::vector<int>> heuristics = heuristicOrders(tiles);
+    const size_t runs = heuristics.size() + static_cast<size_t>(std::max(0, randomStarts));
+
+    std::atomic<int> bestWidth{MAX_WIDTH + 1};
+    std::atomic<int> abandoned{0};
+    std::mutex bestMutex;
+    size_t bestRun = runs;
+
+    auto orderFor = [&](size_t run) {
+        if (run < heuristics.size()) {
+            return heuristics[run];
+        }
+        size_t start = run - heuristics.size();
+        std::vector<int> order = heuristics[start % heuristics.size()];
+        std::mt19937 rng(seed + static_cast<unsigned>(start));
+        perturbOrder(order, rng);
+        return order;
+    };
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t run = next++; run < runs; run = next++) {
+            if (bestWidth.load(std::memory_order_relaxed) <= targetWidth) {
+                break;
+            }
+            std::vector<int> order = orderFor(run);
+            TilePacker<DefaultGrid> packer(makeDefaultGrid());
+
+            bool packed = true;
+            for (int index : order) {
+                if (!packer.addTile(tiles[index])) {
+                    packed = false;
+                    break;
+                }
+                // The bounding width only grows, so this run cannot win any more
+                if (packer.getBoundingWidth() > bestWidth.load(std::memory_order_relaxed)) {
+                    packed = false;
+                    ++abandoned;
+                    break;
+                }
+            }
+            if (!packed) continue;
+
+            int width = packer.getBoundingWidth();
+            std::lock_guard<std::mutex> lock(bestMutex);
+            int best = bestWidth.load(std::memory_order_relaxed);
+            if (width < best || (width == best && run < bestRun)) {
+                bestWidth.store(width, std::memory_order_relaxed);
+                bestRun = run;
+                result.order = std::move(order);
+            }
+        }
+    };
+
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threads = static_cast<int>(std::min<size_t>(threads, runs));
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+
+    result.runs = static_cast<int>(runs);
+    result.abandoned = abandoned.load();
+    if (bestRun < runs) {
+        result.width = bestWidth.load();
+    }
+    return result;
+}
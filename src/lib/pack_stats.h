@@ -0,0 +1,133 @@
+#pragma once
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Optional instrumentation of the packers, compiled in with -DPACK_STATS.
+// Without it PACK_STATS_ADD expands to nothing and PackPhase is an empty
+// object, so the hot paths are the same as before.
+//
+// Counters are kept per thread, as the sweeps pack on several threads at
+// once. Phases are exclusive: while a phase started inside another one runs
+// (a tile placed while its file is read), the outer phase is paused.
+
+enum PackPhaseId { PHASE_LOAD, PHASE_PREPLACE, PHASE_PACK, PHASE_EXPORT, PHASE_COUNT };
+
+inline const char* packPhaseName(int phase) {
+    static const char* names[PHASE_COUNT] = {"load", "preplace", "pack", "export"};
+    return names[phase];
+}
+
+struct PackStats {
+    long long fitsCalls = 0;      // Occupancy::fits calls, one per candidate x tested
+    long long probes = 0;         // Cells (DenseGrid), column words (ColumnMaskGrid) or
+                                  // row lookups (IntervalGrid, FreeRunGrid) examined
+    long long skippedX = 0;       // Candidate x positions jumped over via nextX
+    long long shiftedTiles = 0;   // Placed tiles moved by preplaced pushes and movePreplacedTile
+    long long resumedCopies = 0;  // Tile copies searched from the previous copy's x instead of the start
+    double phaseSeconds[PHASE_COUNT] = {};
+};
+
+#ifdef PACK_STATS
+
+inline PackStats& packStats() {
+    thread_local PackStats stats;
+    return stats;
+}
+
+#define PACK_STATS_ADD(counter, n) (packStats().counter += (n))
+
+// Adds the time until it goes out of scope to its phase
+class PackPhase {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    PackPhaseId id;
+    PackPhase* outer;
+    Clock::time_point start;
+
+    static PackPhase*& current() {
+        thread_local PackPhase* phase = nullptr;
+        return phase;
+    }
+
+    void charge(Clock::time_point now) {
+        packStats().phaseSeconds[id] += std::chrono::duration<double>(now - start).count();
+        start = now;
+    }
+
+public:
+    explicit PackPhase(PackPhaseId phase) : id(phase), outer(current()), start(Clock::now()) {
+        if (outer) outer->charge(start);
+        current() = this;
+    }
+
+    ~PackPhase() {
+        Clock::time_point now = Clock::now();
+        charge(now);
+        if (outer) outer->start = now;
+        current() = outer;
+    }
+
+    PackPhase(const PackPhase&) = delete;
+    PackPhase& operator=(const PackPhase&) = delete;
+};
+
+// Escapes text for a JSON string, e.g. the backslashes of a Windows path
+inline std::string jsonEscape(const std::string& text) {
+    static const char* hex = "0123456789abcdef";
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            escaped += "\\u00";
+            escaped += hex[(c >> 4) & 0xf];
+            escaped += hex[c & 0xf];
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// Writes the calling thread's stats to <resultFile>.stats.json
+inline void exportPackStats(const std::string& resultFile) {
+    const std::string filename = resultFile + ".stats.json";
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "Failed to open stats file: " << filename << "\n";
+        return;
+    }
+
+    const PackStats& stats = packStats();
+    out << "{\n";
+    out << "  \"result\": \"" << jsonEscape(resultFile) << "\",\n";
+    out << "  \"fits_calls\": " << stats.fitsCalls << ",\n";
+    out << "  \"probes\": " << stats.probes << ",\n";
+    out << "  \"skipped_x\": " << stats.skippedX << ",\n";
+    out << "  \"shifted_tiles\": " << stats.shiftedTiles << ",\n";
+    out << "  \"resumed_copies\": " << stats.resumedCopies << ",\n";
+    out << "  \"phase_seconds\": {";
+    for (int phase = 0; phase < PHASE_COUNT; ++phase) {
+        out << (phase ? ", " : "") << "\"" << packPhaseName(phase) << "\": " << stats.phaseSeconds[phase];
+    }
+    out << "}\n}\n";
+    std::cout << "Packing stats exported to: " << filename << "\n";
+}
+
+#else
+
+#define PACK_STATS_ADD(counter, n) ((void)0)
+
+class PackPhase {
+public:
+    explicit PackPhase(PackPhaseId) {}
+};
+
+inline void exportPackStats(const std::string&) {}
+
+#endif
@@ -3,6 +3,7 @@ from tile_process import *
 from joblib import Parallel, delayed
 import threading
 import subprocess
+import ctypes
 
 
 def packing_with_c(tiles, c_directory, ifreordered = True):
@@ -20,6 +21,309 @@ def packing_with_c(tiles, c_directory, ifreordered = True):
     return bounding_width, placed_tiles
 
 
+_tilepack_libs = {}
+_ANNEAL_CALLBACK = ctypes.CFUNCTYPE(None, ctypes.c_double, ctypes.c_int)
+
+def _load_tilepack(lib_path):
+    if lib_path not in _tilepack_libs:
+        lib = ctypes.CDLL(os.path.abspath(lib_path))
+        int_p = ctypes.POINTER(ctypes.c_int)
+        c_int = ctypes.c_int
+        lib.tp_pack.argtypes = [c_int, int_p, int_p, int_p, int_p]
+        lib.tp_pack.restype = c_int
+        lib.tp_sweep.argtypes = [c_int, int_p, int_p, int_p, c_int, int_p, c_int, c_int, c_int, int_p]
+        lib.tp_sweep.restype = c_int
+        lib.tp_pack_modules.argtypes = [c_int, int_p, int_p, c_int, int_p, int_p, int_p, c_int, c_int,
+                                        int_p, int_p]
+        lib.tp_pack_modules.restype = c_int
+        double_p = ctypes.POINTER(ctypes.c_double)
+        lib.tp_epsilon_sweep.argtypes = [c_int, int_p, int_p, double_p, double_p, c_int, c_int, int_p]
+        lib.tp_epsilon_sweep.restype = c_int
+        lib.tp_lower_bound.argtypes = [c_int, int_p, int_p, int_p]
+        lib.tp_lower_bound.restype = c_int
+        lib.tp_search_orderings.argtypes = [c_int, int_p, int_p, c_int, ctypes.c_uint, c_int, int_p, int_p]
+        lib.tp_search_orderings.restype = c_int
+        lib.tp_anneal.argtypes = [c_int, int_p, int_p, int_p, ctypes.c_double, ctypes.c_uint,
+                                  _ANNEAL_CALLBACK, int_p]
+        lib.tp_anneal.restype = c_int
+        lib.tp_generate_tiles.argtypes = [c_int, int_p, int_p, double_p, ctypes.c_double, int_p, c_int,
+                                          c_int, int_p, double_p, int_p]
+        lib.tp_generate_tiles.restype = c_int
+        lib.tp_read_tiles.argtypes = [ctypes.c_char_p, c_int, c_int, int_p, int_p, int_p, int_p, int_p,
+                                      int_p, int_p]
+        lib.tp_read_tiles.restype = c_int
+        _tilepack_libs[lib_path] = lib
+    return _tilepack_libs[lib_path]
+
+def _flatten_tiles(tiles):
+    part_counts = np.array([len(tile) for tile in tiles], dtype=np.intc)
+    parts = np.array([value for tile in tiles for part in tile for value in part], dtype=np.intc)
+    return part_counts, parts
+
+def packing_with_lib(tiles, lib_path = "./lib/libtilepack.so"):
+    """Pack tiles in-process through the tp_pack C interface (see tilepack.h).
+
+    Returns (bounding_width, placed_tiles) in the same shape as read_placed_tiles.
+    """
+    lib = _load_tilepack(lib_path)
+    part_counts, parts = _flatten_tiles(tiles)
+    positions = np.zeros(len(tiles), dtype=np.intc)
+    bounding_width = ctypes.c_int(0)
+
+    int_p = ctypes.POINTER(ctypes.c_int)
+    status = lib.tp_pack(len(tiles),
+                         part_counts.ctypes.data_as(int_p),
+                         parts.ctypes.data_as(int_p),
+                         positions.ctypes.data_as(int_p),
+                         ctypes.byref(bounding_width))
+    if status != 0:
+        print(f"Error: tp_pack failed with status {status}")
+
+    placed_tiles = [(int(x), [tuple(part) for part in tile]) for x, tile in zip(positions, tiles)]
+    return bounding_width.value, placed_tiles
+
+
+def sweep_with_lib(tiles, seam_lst, ratio_lst, ifsorted = True, threads = 0, lib_path = "./lib/libtilepack.so"):
+    """Bounding widths for every (seam, ratio) point in one tp_sweep call.
+
+    Each point splits the tiles at the seam, widens the inter tiles by
+    2*(ratio-1) and packs inter + intra tiles, like time_gate_with_C and
+    tile_expanding. Returns an array of shape (len(seam_lst), len(ratio_lst)).
+    """
+    lib = _load_tilepack(lib_path)
+    part_counts, parts = _flatten_tiles(tiles)
+    seams = np.array(seam_lst, dtype=np.intc)
+    ratios = np.array(ratio_lst, dtype=np.intc)
+    widths = np.zeros((len(seams), len(ratios)), dtype=np.intc)
+
+    int_p = ctypes.POINTER(ctypes.c_int)
+    status = lib.tp_sweep(len(tiles),
+                          part_counts.ctypes.data_as(int_p),
+                          parts.ctypes.data_as(int_p),
+                          seams.ctypes.data_as(int_p), len(seams),
+                          ratios.ctypes.data_as(int_p), len(ratios),
+                          int(ifsorted), threads,
+                          widths.ctypes.data_as(int_p))
+    if status != 0:
+        print(f"Error: tp_sweep failed with status {status}")
+    return widths
+
+
+def pack_modules_with_lib(tiles, seam_lst, separation_lst, ratio_lst, ifsorted = True, threads = 0,
+                          lib_path = "./lib/libtilepack.so"):
+    """Pack a device of len(seam_lst) + 1 modules in one tp_pack_modules call.
+
+    Every seam has its own separation and ratio; the modules are packed
+    concurrently and the inter tiles of each seam afterwards, like
+    tile_generate --modules. Returns (bounding_width, module_widths).
+    """
+    lib = _load_tilepack(lib_path)
+    part_counts, parts = _flatten_tiles(tiles)
+    seams = np.array(seam_lst, dtype=np.intc)
+    separations = np.array(separation_lst, dtype=np.intc)
+    ratios = np.array(ratio_lst, dtype=np.intc)
+    module_widths = np.zeros(len(seams) + 1, dtype=np.intc)
+    bounding_width = ctypes.c_int(0)
+
+    int_p = ctypes.POINTER(ctypes.c_int)
+    status = lib.tp_pack_modules(len(tiles),
+                                 part_counts.ctypes.data_as(int_p),
+                                 parts.ctypes.data_as(int_p),
+                                 len(seams), seams.ctypes.data_as(int_p),
+                                 separations.ctypes.data_as(int_p),
+                                 ratios.ctypes.data_as(int_p),
+                                 int(ifsorted), threads,
+                                 module_widths.ctypes.data_as(int_p),
+                                 ctypes.byref(bounding_width))
+    if status != 0:
+        print(f"Error: tp_pack_modules failed with status {status}")
+    return bounding_width.value, module_widths
+
+
+def epsilon_sweep_with_lib(tiles, gradients, epsilon_lst, order_by_gradient = False, lib_path = "./lib/libtilepack.so"):
+    """Bounding width for every epsilon in one tp_epsilon_sweep call.
+
+    tiles and gradients come from create_gradient_tiles with the smallest
+    epsilon; each epsilon packs the tiles with gradient > epsilon in the given
+    order. Returns an array with one width per epsilon.
+    """
+    lib = _load_tilepack(lib_path)
+    part_counts, parts = _flatten_tiles(tiles)
+    gradients = np.array(gradients, dtype=np.double)
+    thresholds = np.array(epsilon_lst, dtype=np.double)
+    widths = np.zeros(len(thresholds), dtype=np.intc)
+
+    int_p = ctypes.POINTER(ctypes.c_int)
+    double_p = ctypes.POINTER(ctypes.c_double)
+    status = lib.tp_epsilon_sweep(len(tiles),
+                                  part_counts.ctypes.data_as(int_p),
+                                  parts.ctypes.data_as(int_p),
+                                  gradients.ctypes.data_as(double_p),
+                                  thresholds.ctypes.data_as(double_p), len(thresholds),
+                                  int(order_by_gradient),
+                                  widths.ctypes.data_as(int_p))
+    if status != 0:
+        print(f"Error: tp_epsilon_sweep failed with status {status}")
+    return widths
+
+
+def lower_bound_with_lib(tiles, lib_path = "./lib/libtilepack.so"):
+    """Lower bound on the bounding width of any packing of tiles (tp_lower_bound).
+
+    Compare it with a packed width to see how much further search can gain.
+    """
+    lib = _load_tilepack(lib_path)
+    part_counts, parts = _flatten_tiles(tiles)
+    lower_bound = ctypes.c_int(0)
+
+    int_p = ctypes.POINTER(ctypes.c_int)
+    status = lib.tp_lower_bound(len(tiles),
+                                part_counts.ctypes.data_as(int_p),
+                                parts.ctypes.data_as(int_p),
+                                ctypes.byref(lower_bound))
+    if status != 0:
+        print(f"Error: tp_lower_bound failed with status {status}")
+    return lower_bound.value
+
+
+def search_orderings_with_lib(tiles, random_starts = 64, seed = 0, threads = 0, lib_path = "./lib/libtilepack.so"):
+    """Narrowest packing order found by one tp_search_orderings call.
+
+    Packs the built-in heuristic orders (area, height, the process_tiles keys)
+    and random_starts perturbations of them in parallel. Returns
+    (bounding_width, ordered_tiles); pass ordered_tiles to packing_with_lib to
+    get the placements.
+    """
+    lib = _load_tilepack(lib_path)
+    part_counts, parts = _flatten_tiles(tiles)
+    order = np.zeros(len(tiles), dtype=np.intc)
+    bounding_width = ctypes.c_int(0)
+
+    int_p = ctypes.POINTER(ctypes.c_int)
+    status = lib.tp_search_orderings(len(tiles),
+                                     part_counts.ctypes.data_as(int_p),
+                                     parts.ctypes.data_as(int_p),
+                                     random_starts, seed, threads,
+                                     order.ctypes.data_as(int_p),
+                                     ctypes.byref(bounding_width))
+    if status != 0:
+        print(f"Error: tp_search_orderings failed with status {status}")
+        return bounding_width.value, list(tiles)
+    return bounding_width.value, [tiles[i] for i in order]
+
+
+def anneal_with_lib(tiles, seconds = 5.0, seed = 0, verbose = False, lib_path = "./lib/libtilepack.so"):
+    """Improve the packing order of tiles by simulated annealing (tp_anneal).
+
+    Starts from the given order, e.g. the ordered_tiles returned by
+    search_orderings_with_lib, and runs for `seconds`. With verbose, prints
+    the best width each time it improves. Returns (bounding_width, ordered_tiles).
+    """
+    lib = _load_tilepack(lib_path)
+    part_counts, parts = _flatten_tiles(tiles)
+    order = np.arange(len(tiles), dtype=np.intc)
+    bounding_width = ctypes.c_int(0)
+
+    def report(elapsed, width):
+        print(f"{elapsed:.2f}s: bounding width {width}")
+    callback = _ANNEAL_CALLBACK(report) if verbose else _ANNEAL_CALLBACK()
+
+    int_p = ctypes.POINTER(ctypes.c_int)
+    status = lib.tp_anneal(len(tiles),
+                           part_counts.ctypes.data_as(int_p),
+                           parts.ctypes.data_as(int_p),
+                           order.ctypes.data_as(int_p),
+                           seconds, seed, callback,
+                           ctypes.byref(bounding_width))
+    if status != 0:
+        print(f"Error: tp_anneal failed with status {status}")
+        return bounding_width.value, list(tiles)
+    return bounding_width.value, [tiles[i] for i in order]
+
+
+def generate_tiles_with_lib(uop, all_g, epsilon, f_orbs = None, lib_path = "./lib/libtilepack.so"):
+    """create_gradient_tiles through tp_generate_tiles: the same tiles, order and gradients.
+
+    Returns (tiles, gradients), ready for packing_with_lib or epsilon_sweep_with_lib.
+    """
+    lib = _load_tilepack(lib_path)
+    indices = [i for _, i in all_g]
+    orbital_counts = np.array([len(uop.a_idxs[i]) for i in indices], dtype=np.intc)
+    orbitals = np.array([int(v) for i in indices for v in list(uop.a_idxs[i]) + list(uop.i_idxs[i])],
+                        dtype=np.intc)
+    excitation_gradients = np.array([gradient for gradient, _ in all_g], dtype=np.double)
+    f_orbs = np.array(f_orbs if f_orbs is not None else [], dtype=np.intc)
+
+    capacity = 8 * len(indices)
+    parts = np.zeros(4 * capacity, dtype=np.intc)
+    gradients = np.zeros(capacity, dtype=np.double)
+    tile_count = ctypes.c_int(0)
+
+    int_p = ctypes.POINTER(ctypes.c_int)
+    double_p = ctypes.POINTER(ctypes.c_double)
+    status = lib.tp_generate_tiles(len(indices),
+                                   orbital_counts.ctypes.data_as(int_p),
+                                   orbitals.ctypes.data_as(int_p),
+                                   excitation_gradients.ctypes.data_as(double_p),
+                                   epsilon,
+                                   f_orbs.ctypes.data_as(int_p), len(f_orbs),
+                                   capacity,
+                                   parts.ctypes.data_as(int_p),
+                                   gradients.ctypes.data_as(double_p),
+                                   ctypes.byref(tile_count))
+    if status != 0:
+        print(f"Error: tp_generate_tiles failed with status {status}")
+        return [], []
+    count = tile_count.value
+    tiles = [[[int(v) for v in parts[4 * t:4 * t + 4]]] for t in range(count)]
+    return tiles, list(gradients[:count])
+
+
+def read_tiles_with_lib(filename, lib_path = "./lib/libtilepack.so"):
+    """Read a tile or placement file natively through tp_read_tiles (see tilepack.h).
+
+    Takes every layout the packers write (test_tiles.txt, moved_place_tiles.txt,
+    inter_intra_tiles.txt, all_tiles.txt, or .tpk) in place of read_placed_tiles,
+    read_packing_results and read_tile_file. Returns (bounding_width, placed_tiles)
+    with placed_tiles a list of (x, parts); bounding_width is None when the file
+    has no Bounding Width header, and x is 0 for tiles that are not placed.
+    """
+    lib = _load_tilepack(lib_path)
+    int_p = ctypes.POINTER(ctypes.c_int)
+    # A part takes at least 8 characters of text; a second call gets the exact sizes
+    tile_capacity = part_capacity = os.path.getsize(filename) // 8 + 1
+    for _ in range(2):
+        part_counts = np.zeros(tile_capacity, dtype=np.intc)
+        parts = np.zeros(4 * part_capacity, dtype=np.intc)
+        positions = np.zeros(tile_capacity, dtype=np.intc)
+        info = np.zeros(4, dtype=np.intc)
+        tile_count = ctypes.c_int(0)
+        part_count = ctypes.c_int(0)
+        status = lib.tp_read_tiles(os.fsencode(filename), tile_capacity, part_capacity,
+                                   part_counts.ctypes.data_as(int_p),
+                                   parts.ctypes.data_as(int_p),
+                                   positions.ctypes.data_as(int_p),
+                                   None,
+                                   info.ctypes.data_as(int_p),
+                                   ctypes.byref(tile_count),
+                                   ctypes.byref(part_count))
+        if status != -3:
+            break
+        tile_capacity, part_capacity = tile_count.value, part_count.value
+    if status != 0:
+        print(f"Error: tp_read_tiles failed with status {status}")
+        return None, []
+
+    placed_tiles = []
+    part = 0
+    for t in range(tile_count.value):
+        tile_parts = [tuple(int(v) for v in parts[4 * p:4 * p + 4]) for p in range(part, part + part_counts[t])]
+        part += part_counts[t]
+        placed_tiles.append((int(positions[t]), tile_parts))
+    bounding_width = int(info[1]) if info[1] >= 0 else None
+    return bounding_width, placed_tiles
+
+
 def count_single_CNOT(i,j,N):
     count = []
     for i in range(i,j):
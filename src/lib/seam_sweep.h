@@ -0,0 +1,84 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "tile_packing.h"
+
+// Batch version of the seam/ratio loops in plotting.py (time_gate_with_C,
+// time_gate) and tile_process.py (tile_expanding). For every (seam, ratio)
+// point the base tiles are split like split_grid([seam]): a tile whose first
+// part spans rows dy .. dy+h with dy < seam <= dy+h is an inter-module tile
+// (isInter is set) and its first part is widened by 2 * (ratio - 1) like
+// expand_tiles. The packing order is the inter tiles followed by the intra
+// tiles, each in base order, optionally stable-sorted by total area (largest
+// first) as the Python TilePacker does. Seam 0 therefore packs the
+// unmodified tiles.
+
+// Tiles for one sweep point, in packing order
+inline std::vector<Tile> splitAndExpand(const std::vector<Tile>& tiles, int seam, int ratio, bool sortByArea) {
+    std::vector<Tile> inter, intra;
+    for (const auto& tile : tiles) {
+        if (!tile.parts.empty() && tile.parts.front().offsetY < seam
+            && tile.parts.front().offsetY + tile.parts.front().height >= seam) {
+            inter.push_back(tile);
+            inter.back().isInter = true;
+            inter.back().parts.front().width += 2 * (ratio - 1);
+        } else {
+            intra.push_back(tile);
+        }
+    }
+    inter.insert(inter.end(), intra.begin(), intra.end());
+
+    if (sortByArea) {
+        auto area = [](const Tile& tile) {
+            int total = 0;
+            for (const auto& part : tile.parts) total += part.width * part.height;
+            return total;
+        };
+        std::stable_sort(inter.begin(), inter.end(),
+                         [&area](const Tile& a, const Tile& b) { return area(a) > area(b); });
+    }
+    return inter;
+}
+
+// Packs every (seam, ratio) point on `threads` worker threads (0 = one per
+// core). Returns the bounding widths row-major as widths[s * ratios.size() + r],
+// with -1 for points where a tile did not fit.
+inline std::vector<int> sweepSeamsAndRatios(const std::vector<Tile>& tiles, const std::vector<int>& seams,
+                                            const std::vector<int>& ratios, bool sortByArea, int threads = 0) {
+    const size_t points = seams.size() * ratios.size();
+    std::vector<int> widths(points, -1);
+    if (points == 0 || tiles.empty()) {
+        std::fill(widths.begin(), widths.end(), 0);
+        return widths;
+    }
+
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t point = next++; point < points; point = next++) {
+            int seam = seams[point / ratios.size()];
+            int ratio = ratios[point % ratios.size()];
+            TilePacker<DefaultGrid> packer(splitAndExpand(tiles, seam, ratio, sortByArea), makeDefaultGrid());
+            if (packer.packTiles()) {
+                widths[point] = packer.getBoundingWidth();
+            }
+        }
+    };
+
+    if (threads <= 0) {
+        threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    threads = static_cast<int>(std::min<size_t>(threads, points));
+
+    std::vector<std::thread> pool;
+    for (int i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : pool) {
+        thread.join();
+    }
+    return widths;
+}
@@ -0,0 +1,36 @@
+#!/bin/sh
+# Malformed tile files must be rejected with an error, not crash the parser
+# shared by tile_convert, tile_validate and tp_read_tiles.
+#
+#   sh test_malformed_input.sh
+set -e
+cd "$(dirname "$0")"
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+g++ -O2 -std=c++17 tile_convert.cpp -o "$out/tile_convert"
+g++ -O2 -std=c++17 tile_validate.cpp -o "$out/tile_validate"
+
+# Each case: a file name and its contents
+printf -- '-1*2\n' > "$out/negative_copies.txt"
+printf -- '-1\n' > "$out/negative_count.txt"
+printf -- '1*0 2 2 0 0\n' > "$out/zero_copies.txt"
+printf -- '2 2 2 0 0 1\n' > "$out/short_part.txt"
+printf -- '0 2 2 0\n' > "$out/short_placement.txt"
+
+for case in negative_copies negative_count zero_copies short_part short_placement; do
+    for tool in tile_convert tile_validate; do
+        status=0
+        if [ $tool = tile_convert ]; then
+            "$out/tile_convert" "$out/$case.txt" "$out/$case.tpk" 2>/dev/null || status=$?
+        else
+            "$out/tile_validate" "$out/$case.txt" >/dev/null 2>&1 || status=$?
+        fi
+        # 0 accepts the file and 129..254 is a signal; errors return -1 (255)
+        if [ $status -eq 0 ] || { [ $status -gt 128 ] && [ $status -lt 255 ]; }; then
+            echo "$tool $case: exit status $status"
+            exit 1
+        fi
+    done
+done
+echo "Malformed input OK"
@@ -0,0 +1,34 @@
+#!/bin/sh
+# Round trip of tile_packing --stream: its output, with the Bounding Width and
+# Lower Bound lines after the placements, must read back as a valid placement
+# in tile_validate and tile_process.read_placed_tiles.
+#
+#   sh test_stream_roundtrip.sh [tile list]    (default ../../test_tiles.txt)
+set -e
+cd "$(dirname "$0")"
+tiles=$(cd "$(dirname "${1:-../../test_tiles.txt}")" && pwd)/$(basename "${1:-../../test_tiles.txt}")
+out=$(mktemp -d)
+trap 'rm -rf "$out"' EXIT
+
+g++ -O2 -std=c++17 tile_packing.cpp -o "$out/tile_packing"
+g++ -O2 -std=c++17 tile_validate.cpp -o "$out/tile_validate"
+
+"$out/tile_packing" --stream < "$tiles" > "$out/stream.txt"
+"$out/tile_validate" "$out/stream.txt"
+
+if python3 -c "import numpy" 2>/dev/null; then
+    python3 - "$out/stream.txt" <<'EOF'
+import ast, sys
+import numpy as np
+
+# Only read_placed_tiles is needed; importing tile_process pulls in qiskit
+source = open("tile_process.py").read()
+for node in ast.parse(source).body:
+    if isinstance(node, ast.FunctionDef) and node.name == "read_placed_tiles":
+        exec(compile(ast.Module([node], []), "tile_process.py", "exec"))
+result = read_placed_tiles(sys.argv[1])
+if not result or result[0] <= 0 or not result[1]:
+    sys.exit("read_placed_tiles could not read the stream output")
+EOF
+fi
+echo "Stream round trip OK"
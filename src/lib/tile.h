@@ -0,0 +1,247 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+// Represents a part of a tile
+struct TilePart {
+    int width, height, offsetX, offsetY;
+    TilePart(int w, int h, int dx, int dy) : width(w), height(h), offsetX(dx), offsetY(dy) {}
+
+    bool operator==(const TilePart& other) const {
+        return width == other.width && height == other.height && offsetX == other.offsetX && offsetY == other.offsetY;
+    }
+};
+
+// Parts lying next to each other in memory, e.g. a Tile's or a TileStore's
+struct PartSpan {
+    const TilePart* first = nullptr;
+    const TilePart* last = nullptr;
+
+    PartSpan() = default;
+    PartSpan(const TilePart* begin, const TilePart* end) : first(begin), last(end) {}
+    PartSpan(const std::vector<TilePart>& parts) : first(parts.data()), last(parts.data() + parts.size()) {}
+
+    const TilePart* begin() const { return first; }
+    const TilePart* end() const { return last; }
+    size_t size() const { return static_cast<size_t>(last - first); }
+    bool empty() const { return first == last; }
+    const TilePart& front() const { return *first; }
+};
+
+class Tile;
+
+// A tile without owning its parts. Tiles convert to views implicitly, so the
+// packer works on Tiles and on tiles held in a TileStore alike without
+// copying parts. A view is valid as long as what it was taken from.
+struct TileView {
+    PartSpan parts;
+    bool isPreplaced = false;
+    bool isInter = false;
+    int positionX = 0;
+    int separation = 0;
+
+    TileView() = default;
+    TileView(PartSpan p, bool preplaced = false, int x = 0) : parts(p), isPreplaced(preplaced), positionX(x) {}
+    TileView(const Tile& tile);
+
+    void print() const {
+        std::cout << "Tile with " << parts.size() << " parts:\n";
+        for (const auto& part : parts) {
+            std::cout << "  Width: " << part.width
+                      << ", Height: " << part.height
+                      << ", OffsetX: " << part.offsetX
+                      << ", OffsetY: " << part.offsetY << '\n';
+        }
+    }
+
+    int getTotalWidth() const {
+        int maxX = 0;
+        for (const auto& part : parts) {
+            maxX = std::max(maxX, part.offsetX + part.width);
+        }
+        return maxX;
+    }
+
+    int getTotalHeight() const {
+        int maxY = 0;
+        for (const auto& part : parts) {
+            maxY = std::max(maxY, part.offsetY + part.height);
+        }
+        return maxY;
+    }
+
+    // True if the tiles need the same cells relative to their x, e.g. the
+    // copies create_circuit_tile emits of one excitation
+    bool sameShape(const TileView& other) const {
+        return std::equal(parts.begin(), parts.end(), other.parts.begin(), other.parts.end())
+            && isInter == other.isInter && separation == other.separation;
+    }
+};
+
+// A tile of exactly one part, which every tile generate_circuit_tile emits
+// is. It offers the members of a TileView the packer reads, but its part
+// count is known at compile time, so a packer instantiated for it has no part
+// loops left (TilePacker::placeRun).
+struct RectTile {
+    std::array<TilePart, 1> parts;
+    bool isPreplaced = false;
+    bool isInter = false;
+    int positionX = 0;
+    int separation = 0;
+
+    // The view must have one part
+    explicit RectTile(const TileView& view)
+        : parts{view.parts.front()}, isPreplaced(view.isPreplaced), isInter(view.isInter),
+          positionX(view.positionX), separation(view.separation) {}
+
+    int getTotalWidth() const { return parts[0].offsetX + parts[0].width; }
+    int getTotalHeight() const { return parts[0].offsetY + parts[0].height; }
+};
+
+// Represents a tile consisting of multiple parts
+class Tile {
+public:
+    std::vector<TilePart> parts;
+    bool isPreplaced = false;
+    bool isInter = false;  // Crosses the module seam in double packing
+    int positionX = 0;     // Absolute x position for preplaced tiles or placed free tiles
+    int separation = 0;    // Extra width an inter tile keeps free to its right
+
+    explicit Tile(const std::vector<TilePart>& p, bool preplaced = false, int x = 0)
+        : parts(p), isPreplaced(preplaced), positionX(x) {}
+
+    // Copies the parts of a view, e.g. one of TilePacker::getPlacedTiles()
+    explicit Tile(const TileView& view)
+        : parts(view.parts.begin(), view.parts.end()), isPreplaced(view.isPreplaced), isInter(view.isInter),
+          positionX(view.positionX), separation(view.separation) {}
+
+    // Function to print the tile's parts
+    void print() const { TileView(*this).print(); }
+
+    int getTotalWidth() const { return TileView(*this).getTotalWidth(); }
+
+    int getTotalHeight() const { return TileView(*this).getTotalHeight(); }
+
+    bool sameShape(const TileView& other) const { return TileView(*this).sameShape(other); }
+};
+
+inline TileView::TileView(const Tile& tile)
+    : parts(tile.parts), isPreplaced(tile.isPreplaced), isInter(tile.isInter), positionX(tile.positionX),
+      separation(tile.separation) {}
+
+// Tiles stored structure-of-arrays: the parts of every tile back to back in
+// one shared array, tile i owning parts[partBegin[i] .. partBegin[i + 1]), and
+// its kind and separation in arrays of their own. Adding a tile allocates
+// nothing once the arrays have grown, unlike a Tile with its own part vector.
+// Views handed out are invalidated by the next add.
+class TileStore {
+private:
+    enum : uint8_t { PREPLACED = 1, INTER = 2 };
+
+    std::vector<TilePart> parts;
+    std::vector<uint32_t> partBegin{0};
+    std::vector<uint8_t> kinds;
+    std::vector<int> separations;
+
+public:
+    void reserve(size_t tileCount, size_t partCount) {
+        parts.reserve(partCount);
+        partBegin.reserve(tileCount + 1);
+        kinds.reserve(tileCount);
+        separations.reserve(tileCount);
+    }
+
+    // Appends the tile and returns its index. The view may point into this
+    // store, e.g. be one it handed out.
+    uint32_t add(const TileView& tile) {
+        size_t count = tile.parts.size();
+        if (!parts.empty() && tile.parts.begin() >= parts.data() && tile.parts.begin() < parts.data() + parts.size()) {
+            size_t from = static_cast<size_t>(tile.parts.begin() - parts.data());
+            parts.reserve(parts.size() + count);
+            for (size_t p = from; p < from + count; ++p) {
+                parts.push_back(parts[p]);
+            }
+        } else {
+            parts.insert(parts.end(), tile.parts.begin(), tile.parts.end());
+        }
+        partBegin.push_back(static_cast<uint32_t>(parts.size()));
+        kinds.push_back((tile.isPreplaced ? PREPLACED : 0) | (tile.isInter ? INTER : 0));
+        separations.push_back(tile.separation);
+        return static_cast<uint32_t>(kinds.size() - 1);
+    }
+
+    // Tile i, at x = 0
+    TileView operator[](size_t i) const {
+        TileView tile(PartSpan(parts.data() + partBegin[i], parts.data() + partBegin[i + 1]),
+                      (kinds[i] & PREPLACED) != 0);
+        tile.isInter = (kinds[i] & INTER) != 0;
+        tile.separation = separations[i];
+        return tile;
+    }
+
+    size_t size() const { return kinds.size(); }
+
+    // Drops every tile from index `count` on
+    void truncate(size_t count) {
+        if (count >= size()) return;
+        parts.erase(parts.begin() + partBegin[count], parts.end());
+        partBegin.resize(count + 1);
+        kinds.resize(count);
+        separations.resize(count);
+    }
+};
+
+// A placement as the packer records it: which stored tile went where
+struct PlacedTile {
+    uint32_t tile;  // Index into the packer's TileStore
+    int x;
+};
+
+// The placed tiles of a packer as views with positionX set, in placement
+// order; indexing and iteration build each view on the fly
+class PlacedTileList {
+private:
+    const TileStore* store;
+    const std::vector<PlacedTile>* placed;
+
+public:
+    class iterator {
+    private:
+        const TileStore* store;
+        const PlacedTile* placed;
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = TileView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = TileView;
+
+        iterator(const TileStore* s, const PlacedTile* p) : store(s), placed(p) {}
+        TileView operator*() const {
+            TileView tile = (*store)[placed->tile];
+            tile.positionX = placed->x;
+            return tile;
+        }
+        iterator& operator++() {
+            ++placed;
+            return *this;
+        }
+        bool operator==(const iterator& other) const { return placed == other.placed; }
+        bool operator!=(const iterator& other) const { return placed != other.placed; }
+    };
+
+    PlacedTileList(const TileStore& s, const std::vector<PlacedTile>& p) : store(&s), placed(&p) {}
+
+    TileView operator[](size_t i) const { return *iterator(store, placed->data() + i); }
+    size_t size() const { return placed->size(); }
+    bool empty() const { return placed->empty(); }
+    iterator begin() const { return iterator(store, placed->data()); }
+    iterator end() const { return iterator(store, placed->data() + placed->size()); }
+};
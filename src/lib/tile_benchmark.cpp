@@ -0,0 +1,549 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "tile_packing.h"
+#include "tile_io.h"
+
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+// Benchmarks the packers on the tile sets derived from the molecule data.
+// The sets are exported by export_benchmark_sets() in tile_process.py, one
+// .tpk per data directory, epsilon and distance (data_H_12, data_H_12_uniform,
+// data_cr_2, data_cr2_12o):
+//
+//   tile_benchmark bench_tiles                             print the table
+//   tile_benchmark bench_tiles --json current.json         also save the results
+//   tile_benchmark bench_tiles --baseline baseline.json    flag regressions
+//   tile_benchmark bench_tiles --engine double             one engine only
+//   tile_benchmark bench_tiles --max-tiles 20000           skip the largest sets
+//
+// Every set runs through three engines:
+//   plain      all tiles in file order (tile_packing)
+//   preplaced  the first half of the set packed and fixed, the second half
+//              packed around it (preplaced_tile_packing)
+//   double     tiles crossing the middle row are inter tiles with the
+//              first-pass separation of double_packing
+// Read, pack and export are timed separately, each the median of --repeat
+// runs. Probes are the candidate positions tested per tile. Peak kB is how
+// far one more run of the engine takes the RSS above where it started,
+// measured in a forked child so that it does not depend on the sets and
+// engines run before (on Windows it is still the process high-water mark).
+// It is compared against a baseline only when that ran the same sets.
+
+using Clock = std::chrono::steady_clock;
+
+// First fit that counts the candidate positions it tests
+struct CountingFirstFit : FirstFit {
+    static inline long long probes = 0;
+
+    template <typename Fits>
+    static int search(int x, Fits&& fits) {
+        return FirstFit::search(x, [&](int candidate, int& nextX) {
+            ++probes;
+            return fits(candidate, nextX);
+        });
+    }
+};
+
+using PlainPacker = TilePacker<DefaultGrid, CountingFirstFit>;
+using DoublePacker = TilePacker<DefaultGrid, CountingFirstFit, InterSeparation>;
+
+struct BenchmarkResult {
+    std::string set;
+    std::string engine;
+    int tiles = 0;
+    int width = -1;
+    double readNs = 0;    // Per tile, like the two below
+    double packNs = 0;
+    double exportNs = 0;
+    double probes = 0;
+    long peakRssKb = 0;   // Peak RSS growth of one run
+};
+
+#ifdef __linux__
+// A "Name: value kB" field of /proc/self/status, e.g. VmRSS: or VmHWM:
+static long procStatusKb(const std::string& field) {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.compare(0, field.size(), field) == 0) {
+            return std::stol(line.substr(field.size()));
+        }
+    }
+    return 0;
+}
+#endif
+
+// High-water mark of the process; on Linux it can be reset through clear_refs
+static long peakRssKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<long>(counters.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+#elif defined(__linux__)
+    return procStatusKb("VmHWM:");
+#else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;  // Bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// Peak RSS growth of one call of runOnce. On POSIX the call runs in a forked
+// child, which starts out with the memory it shares with this process, and
+// reports how far above that it went.
+template <typename Engine>
+static long enginePeakRssKb(Engine&& runOnce) {
+#ifdef _WIN32
+    runOnce();
+    return peakRssKb();
+#else
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return 0;
+    }
+    std::cout.flush();
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+#ifdef __linux__
+        // Hand back what the earlier runs freed, which the run would otherwise
+        // reuse without it counting, and restart the high-water mark from here
+#ifdef __GLIBC__
+        malloc_trim(0);
+#endif
+        std::ofstream("/proc/self/clear_refs") << "5";
+        const long before = procStatusKb("VmRSS:");
+#else
+        const long before = peakRssKb();
+#endif
+        runOnce();
+        long growth = peakRssKb() - before;
+        ssize_t written = write(fds[1], &growth, sizeof(growth));
+        _exit(written == sizeof(growth) ? 0 : 1);
+    }
+    close(fds[1]);
+    long growth = 0;
+    if (pid < 0 || read(fds[0], &growth, sizeof(growth)) != sizeof(growth)) {
+        std::cerr << "Failed to measure peak RSS in a child process\n";
+        growth = 0;
+    }
+    close(fds[0]);
+    if (pid > 0) {
+        waitpid(pid, nullptr, 0);
+    }
+    return growth;
+#endif
+}
+
+static double elapsedNs(Clock::time_point begin) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - begin).count();
+}
+
+static double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+// One timed run of an engine: nanoseconds per phase, width and probes
+struct EngineRun {
+    double readNs = 0, packNs = 0, exportNs = 0;
+    int width = -1;
+    long long probes = 0;
+};
+
+static EngineRun runPlain(const std::string& input, const std::string& output) {
+    EngineRun run;
+    auto begin = Clock::now();
+    std::vector<Tile> tiles;
+    readTiles(input, tiles);
+    run.readNs = elapsedNs(begin);
+
+    CountingFirstFit::probes = 0;
+    begin = Clock::now();
+    PlainPacker packer(tiles, makeDefaultGrid());
+    bool packed = packer.packTiles();
+    run.packNs = elapsedNs(begin);
+    run.probes = CountingFirstFit::probes;
+    run.width = packed ? packer.getBoundingWidth() : -1;
+
+    begin = Clock::now();
+    packer.exportResults(output);
+    run.exportNs = elapsedNs(begin);
+    return run;
+}
+
+// The preplaced tiles of a set: its first half, packed first-fit in order
+static std::vector<Tile> preplacedHalf(const std::vector<Tile>& tiles) {
+    PlainPacker packer(makeDefaultGrid());
+    for (size_t i = 0; i < tiles.size() / 2; ++i) {
+        packer.placeTile(tiles[i]);
+    }
+    PlacedTileList placed = packer.getPlacedTiles();
+    return std::vector<Tile>(placed.begin(), placed.end());
+}
+
+static EngineRun runPreplaced(const std::string& input, const std::vector<Tile>& preplaced,
+                              const std::string& output) {
+    EngineRun run;
+    auto begin = Clock::now();
+    std::vector<Tile> tiles;
+    readTiles(input, tiles);
+    run.readNs = elapsedNs(begin);
+
+    CountingFirstFit::probes = 0;
+    begin = Clock::now();
+    PlainPacker packer(makeDefaultGrid());
+    for (const auto& tile : preplaced) {
+        packer.addPreplacedTile(tile.positionX, tile.parts);
+    }
+    bool packed = true;
+    for (size_t i = preplaced.size(); i < tiles.size() && packed; ++i) {
+        packed = packer.placeTile(tiles[i]) != -1;
+    }
+    run.packNs = elapsedNs(begin);
+    run.probes = CountingFirstFit::probes;
+    run.width = packed ? packer.getBoundingWidth() : -1;
+
+    begin = Clock::now();
+    packer.exportResults(output);
+    run.exportNs = elapsedNs(begin);
+    return run;
+}
+
+static EngineRun runDouble(const std::string& input, const std::string& output) {
+    EngineRun run;
+    auto begin = Clock::now();
+    std::vector<Tile> tiles;
+    readTiles(input, tiles);
+
+    // Inter tiles cross the seam in the middle of the set, as in split_grid;
+    // the separation is the widest part read so far (first pass)
+    int height = 0;
+    for (const auto& tile : tiles) {
+        height = std::max(height, tile.getTotalHeight());
+    }
+    const int seam = height / 2;
+    int maxWidth = 0;
+    for (auto& tile : tiles) {
+        for (const auto& part : tile.parts) {
+            maxWidth = std::max(maxWidth, part.width);
+        }
+        const TilePart& first = tile.parts.front();
+        if (first.offsetY < seam && first.offsetY + first.height >= seam) {
+            tile.isInter = true;
+            tile.separation = maxWidth;
+        }
+    }
+    run.readNs = elapsedNs(begin);
+
+    CountingFirstFit::probes = 0;
+    begin = Clock::now();
+    DoublePacker packer(tiles, makeDefaultGrid());
+    bool packed = packer.packTiles();
+    run.packNs = elapsedNs(begin);
+    run.probes = CountingFirstFit::probes;
+    run.width = packed ? packer.getBoundingWidth() : -1;
+
+    begin = Clock::now();
+    packer.exportResults(output);
+    run.exportNs = elapsedNs(begin);
+    return run;
+}
+
+template <typename Engine>
+static BenchmarkResult benchmark(const std::string& set, const std::string& engine, int tileCount,
+                                 int repeat, Engine&& runOnce) {
+    std::vector<double> read, pack, exported;
+    EngineRun run;
+    for (int i = 0; i < repeat; ++i) {
+        run = runOnce();
+        read.push_back(run.readNs);
+        pack.push_back(run.packNs);
+        exported.push_back(run.exportNs);
+    }
+
+    BenchmarkResult result;
+    result.set = set;
+    result.engine = engine;
+    result.tiles = tileCount;
+    result.width = run.width;
+    const double perTile = 1.0 / std::max(1, tileCount);
+    result.readNs = median(read) * perTile;
+    result.packNs = median(pack) * perTile;
+    result.exportNs = median(exported) * perTile;
+    result.probes = run.probes * perTile;
+    result.peakRssKb = enginePeakRssKb(runOnce);
+    return result;
+}
+
+// Names of the sets benchmarked, in order, without repeats
+static std::vector<std::string> setList(const std::vector<BenchmarkResult>& results) {
+    std::vector<std::string> sets;
+    for (const auto& r : results) {
+        if (sets.empty() || sets.back() != r.set) sets.push_back(r.set);
+    }
+    return sets;
+}
+
+static void writeJson(const std::string& filename, const std::vector<BenchmarkResult>& results) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "Failed to open output file: " << filename << "\n";
+        return;
+    }
+    out << std::fixed << std::setprecision(2);
+    const std::vector<std::string> sets = setList(results);
+    out << "{\n  \"sets\": [";
+    for (size_t i = 0; i < sets.size(); ++i) {
+        out << (i > 0 ? ", " : "") << "\"" << sets[i] << "\"";
+    }
+    out << "],\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& r = results[i];
+        out << "    {\"set\": \"" << r.set << "\", \"engine\": \"" << r.engine << "\", \"tiles\": " << r.tiles
+            << ", \"width\": " << r.width << ", \"read_ns_per_tile\": " << r.readNs
+            << ", \"pack_ns_per_tile\": " << r.packNs << ", \"export_ns_per_tile\": " << r.exportNs
+            << ", \"probes_per_tile\": " << r.probes << ", \"peak_rss_kb\": " << r.peakRssKb << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// Reads a file written by writeJson: the set list, then one flat object per
+// result. Files from before the set list was recorded leave `sets` empty.
+static bool readJson(const std::string& filename, std::map<std::string, BenchmarkResult>& results,
+                     std::vector<std::string>& sets) {
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "Failed to open baseline file: " << filename << "\n";
+        return false;
+    }
+
+    auto unquote = [](std::string text) {
+        text.erase(0, text.find_first_not_of(" \""));
+        text.erase(text.find_last_not_of(" \"") + 1);
+        return text;
+    };
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.find("\"sets\": [") != std::string::npos) {
+            size_t open = line.find('['), close = line.rfind(']');
+            std::istringstream iss(line.substr(open + 1, close - open - 1));
+            std::string name;
+            while (std::getline(iss, name, ',')) {
+                if (!unquote(name).empty()) sets.push_back(unquote(name));
+            }
+            continue;
+        }
+
+        size_t open = line.find('{'), close = line.rfind('}');
+        if (open == std::string::npos || close == std::string::npos || line.find("\"set\"") == std::string::npos) {
+            continue;
+        }
+
+        // "key": value pairs; string values are quoted, numbers are not
+        std::map<std::string, std::string> fields;
+        std::istringstream iss(line.substr(open + 1, close - open - 1));
+        std::string pair;
+        while (std::getline(iss, pair, ',')) {
+            size_t colon = pair.find(':');
+            if (colon == std::string::npos) continue;
+            fields[unquote(pair.substr(0, colon))] = unquote(pair.substr(colon + 1));
+        }
+
+        BenchmarkResult r;
+        try {
+            r.set = fields.at("set");
+            r.engine = fields.at("engine");
+            r.tiles = std::stoi(fields.at("tiles"));
+            r.width = std::stoi(fields.at("width"));
+            r.readNs = std::stod(fields.at("read_ns_per_tile"));
+            r.packNs = std::stod(fields.at("pack_ns_per_tile"));
+            r.exportNs = std::stod(fields.at("export_ns_per_tile"));
+            r.probes = std::stod(fields.at("probes_per_tile"));
+            r.peakRssKb = std::stol(fields.at("peak_rss_kb"));
+        } catch (const std::exception&) {
+            std::cerr << "Invalid baseline entry: " << line << "\n";
+            return false;
+        }
+        results[r.set + " " + r.engine] = r;
+    }
+    return true;
+}
+
+// Compares against the baseline and prints every regression. Timings may
+// exceed the baseline by `tolerance` (a fraction) before they count; widths
+// and probe counts are deterministic, so any change is reported. Peak RSS is
+// compared only when compareRss is set.
+static int compareWithBaseline(const std::vector<BenchmarkResult>& results,
+                               const std::map<std::string, BenchmarkResult>& baseline, double tolerance,
+                               bool compareRss) {
+    int regressions = 0;
+    auto report = [&](const BenchmarkResult& r, const std::string& what, double now, double before) {
+        std::cout << "REGRESSION " << r.set << " " << r.engine << ": " << what << " " << before
+                  << " -> " << now << "\n";
+        ++regressions;
+    };
+
+    for (const auto& r : results) {
+        auto it = baseline.find(r.set + " " + r.engine);
+        if (it == baseline.end()) {
+            std::cout << "No baseline for " << r.set << " " << r.engine << "\n";
+            continue;
+        }
+        const BenchmarkResult& b = it->second;
+        if (r.width != b.width) report(r, "width", r.width, b.width);
+        if (r.probes > b.probes + 0.005) report(r, "probes/tile", r.probes, b.probes);
+        if (r.readNs > b.readNs * (1 + tolerance)) report(r, "read ns/tile", r.readNs, b.readNs);
+        if (r.packNs > b.packNs * (1 + tolerance)) report(r, "pack ns/tile", r.packNs, b.packNs);
+        if (r.exportNs > b.exportNs * (1 + tolerance)) report(r, "export ns/tile", r.exportNs, b.exportNs);
+        if (compareRss && r.peakRssKb > b.peakRssKb * (1 + tolerance)) report(r, "peak RSS kB", r.peakRssKb, b.peakRssKb);
+    }
+    return regressions;
+}
+
+static void printResult(const BenchmarkResult& r) {
+    std::cout << std::left << std::setw(36) << r.set << std::setw(11) << r.engine << std::right
+              << std::setw(7) << r.tiles << std::setw(9) << r.width << std::fixed << std::setprecision(1)
+              << std::setw(11) << r.readNs << std::setw(11) << r.packNs << std::setw(11) << r.exportNs
+              << std::setw(10) << r.probes << std::setw(11) << r.peakRssKb << "\n";
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> inputs;
+    std::string jsonFile, baselineFile, only;
+    int repeat = 5;
+    size_t maxTiles = 0;
+    double tolerance = 0.25;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "--json" || arg == "--baseline" || arg == "--engine" || arg == "--repeat" ||
+             arg == "--max-tiles" || arg == "--tolerance") && i + 1 < argc) {
+            std::string value = argv[++i];
+            if (arg == "--json") jsonFile = value;
+            else if (arg == "--baseline") baselineFile = value;
+            else if (arg == "--engine") only = value;
+            else if (arg == "--repeat") repeat = std::max(1, std::stoi(value));
+            else if (arg == "--max-tiles") maxTiles = std::stoul(value);
+            else tolerance = std::stod(value);
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "Usage: tile_benchmark <tile sets or directories> [--repeat N] [--json out.json]"
+                         " [--baseline baseline.json] [--tolerance 0.25] [--engine plain|preplaced|double]"
+                         " [--max-tiles N]\n";
+            return -1;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+    if (inputs.empty()) {
+        inputs.push_back("bench_tiles");
+    }
+
+    // Directories contribute their .tpk and .txt files, sorted by name
+    std::vector<std::filesystem::path> sets;
+    for (const auto& input : inputs) {
+        if (std::filesystem::is_directory(input)) {
+            std::vector<std::filesystem::path> found;
+            for (const auto& entry : std::filesystem::directory_iterator(input)) {
+                auto extension = entry.path().extension();
+                if (entry.is_regular_file() && (extension == ".tpk" || extension == ".txt")) {
+                    found.push_back(entry.path());
+                }
+            }
+            std::sort(found.begin(), found.end());
+            sets.insert(sets.end(), found.begin(), found.end());
+        } else {
+            sets.emplace_back(input);
+        }
+    }
+
+    const std::filesystem::path scratch = std::filesystem::temp_directory_path() / "tile_benchmark";
+    std::filesystem::create_directories(scratch);
+
+    std::cout << std::left << std::setw(36) << "set" << std::setw(11) << "engine" << std::right
+              << std::setw(7) << "tiles" << std::setw(9) << "width" << std::setw(11) << "read ns"
+              << std::setw(11) << "pack ns" << std::setw(11) << "export ns" << std::setw(10) << "probes"
+              << std::setw(11) << "peak kB" << "\n";
+
+    std::vector<BenchmarkResult> results;
+    for (const auto& path : sets) {
+        std::vector<Tile> tiles;
+        if (readTiles(path.string(), tiles) != 0 || tiles.empty()) {
+            std::cerr << "Skipping " << path << ": no tiles\n";
+            continue;
+        }
+        if (maxTiles > 0 && tiles.size() > maxTiles) {
+            std::cerr << "Skipping " << path << ": " << tiles.size() << " tiles\n";
+            continue;
+        }
+        const std::string input = path.string();
+        const std::string set = path.stem().string();
+        const std::string output = (scratch / (set + ".txt")).string();
+        const int count = static_cast<int>(tiles.size());
+
+        auto selected = [&](const char* engine) { return only.empty() || only == engine; };
+
+        if (selected("plain")) {
+            results.push_back(benchmark(set, "plain", count, repeat, [&] { return runPlain(input, output); }));
+            printResult(results.back());
+        }
+        if (selected("preplaced")) {
+            const std::vector<Tile> preplaced = preplacedHalf(tiles);
+            results.push_back(benchmark(set, "preplaced", count, repeat,
+                                        [&] { return runPreplaced(input, preplaced, output); }));
+            printResult(results.back());
+        }
+        if (selected("double")) {
+            results.push_back(benchmark(set, "double", count, repeat, [&] { return runDouble(input, output); }));
+            printResult(results.back());
+        }
+    }
+    std::filesystem::remove_all(scratch);
+
+    if (!jsonFile.empty()) {
+        writeJson(jsonFile, results);
+        std::cout << "Results saved to " << jsonFile << "\n";
+    }
+
+    if (!baselineFile.empty()) {
+        std::map<std::string, BenchmarkResult> baseline;
+        std::vector<std::string> baselineSets;
+        if (!readJson(baselineFile, baseline, baselineSets)) {
+            return -1;
+        }
+        const bool sameSets = baselineSets == setList(results);
+        if (!sameSets) {
+            std::cout << "Peak RSS not compared: " << baselineFile << " was run on a different set list\n";
+        }
+        int regressions = compareWithBaseline(results, baseline, tolerance, sameSets);
+        std::cout << regressions << " regression(s) against " << baselineFile << "\n";
+        return regressions == 0 ? 0 : 1;
+    }
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "tile_file.h"
+#include "tile_text.h"
+
+// Converts between the text tile formats and the binary .tpk format of
+// tile_file.h. The direction is picked from the input: a .tpk input is written
+// back as text in the layout it was created from, anything else is parsed as
+// text and written as .tpk.
+//
+//   tile_convert test_tiles.txt test_tiles.tpk
+//   tile_convert all_tiles.tpk all_tiles.txt
+
+static void writeParts(std::ofstream& out, const TileFileView& view, size_t tile) {
+    for (int p = view.partBegin[tile]; p < view.partBegin[tile + 1]; ++p) {
+        out << view.width[p] << " " << view.height[p] << " "
+            << view.offsetX[p] << " " << view.offsetY[p] << " ";
+    }
+}
+
+static bool writeTextTiles(const std::string& filename, const TileFileView& view) {
+    std::ofstream out(filename);
+    if (!out) {
+        std::cerr << "Failed to open output file: " << filename << "\n";
+        return false;
+    }
+
+    const TileFileHeader& header = *view.header;
+    if (header.layout == LAYOUT_PLACED || header.layout == LAYOUT_RESULT) {
+        out << "Bounding Width: " << header.boundingWidth << "\n";
+    }
+    if (header.layout == LAYOUT_RESULT) {
+        out << "Bounding Height: " << header.boundingHeight << "\n";
+    }
+    if ((header.layout == LAYOUT_PLACED || header.layout == LAYOUT_RESULT) && header.lowerBound > 0) {
+        out << "Lower Bound: " << header.lowerBound << "\n";
+    }
+
+    for (size_t i = 0; i < view.tileCount(); ++i) {
+        switch (header.layout) {
+        case LAYOUT_TILE_LIST:
+            out << view.partCount(i) << "\n";
+            for (int p = view.partBegin[i]; p < view.partBegin[i + 1]; ++p) {
+                out << view.width[p] << " " << view.height[p] << " "
+                    << view.offsetX[p] << " " << view.offsetY[p] << "\n";
+            }
+            break;
+        case LAYOUT_INTER_INTRA:
+            out << ((view.flags[i] & TILE_INTER) ? "interTile" : "intraTile") << "\n";
+            for (int p = view.partBegin[i]; p < view.partBegin[i + 1]; ++p) {
+                out << view.width[p] << " " << view.height[p] << " "
+                    << view.offsetX[p] << " " << view.offsetY[p] << "\n";
+            }
+            break;
+        case LAYOUT_PLACED:
+            out << view.positionX[i] << " ";
+            writeParts(out, view, i);
+            out << "\n";
+            break;
+        case LAYOUT_RESULT:
+            out << ((view.flags[i] & TILE_PREPLACED) ? "Preplaced " : "Placed ") << view.positionX[i] << " ";
+            writeParts(out, view, i);
+            out << "\n";
+            break;
+        default:
+            std::cerr << "Unknown tile file layout: " << header.layout << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: tile_convert <input> <output>\n";
+        return -1;
+    }
+    const std::string input = argv[1];
+    const std::string output = argv[2];
+
+    if (isTileFile(input)) {
+        TileFileView view;
+        if (!view.open(input) || !writeTextTiles(output, view)) {
+            return -1;
+        }
+        std::cout << "Converted " << view.tileCount() << " tiles to text: " << output << "\n";
+    } else {
+        TileArrays tiles;
+        if (!readTextTiles(input, tiles) || !writeTileFile(output, tiles)) {
+            return -1;
+        }
+        std::cout << "Converted " << tiles.tileCount() << " tiles to binary: " << output << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,295 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Binary tile file (.tpk). One layout covers tile lists, preplaced tiles and
+// placement results, so every packer can map its input and write its output
+// without text parsing. All fields are little-endian 32-bit integers:
+//
+//   TileFileHeader                      32 bytes
+//   int32  partBegin[tileCount + 1]     index of each tile's first part; last = partCount
+//   int32  width[partCount]
+//   int32  height[partCount]
+//   int32  offsetX[partCount]
+//   int32  offsetY[partCount]
+//   int32  positionX[tileCount]         0 for tiles that are not placed yet
+//   uint32 flags[tileCount]             TileFlags
+//
+// `layout` records which text format the file corresponds to, so tile_convert
+// can write it back in the form the Python scripts read.
+
+constexpr char TILE_FILE_MAGIC[4] = {'T', 'P', 'K', 'F'};
+constexpr uint32_t TILE_FILE_VERSION = 1;
+
+enum TileFileLayout : uint32_t {
+    LAYOUT_TILE_LIST = 0,    // test_tiles.txt: part count line, then parts
+    LAYOUT_INTER_INTRA = 1,  // inter_intra_tiles.txt: interTile/intraTile line, then the part
+    LAYOUT_PLACED = 2,       // placed_tiles.txt, moved_place_tiles.txt: Bounding Width, then "x parts"
+    LAYOUT_RESULT = 3        // all_tiles.txt, result_tiles.txt: Bounding Width/Height, then "Placed x parts"
+};
+
+enum TileFlags : uint32_t {
+    TILE_PLACED = 1u << 0,
+    TILE_PREPLACED = 1u << 1,
+    TILE_INTER = 1u << 2
+};
+
+struct TileFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t layout;
+    uint32_t tileCount;
+    uint32_t partCount;
+    int32_t boundingWidth;   // -1 when not known
+    int32_t boundingHeight;  // -1 when not known
+    int32_t lowerBound;      // Lower bound on the bounding width, 0 when not known
+};
+static_assert(sizeof(TileFileHeader) == 32, "TileFileHeader must stay 32 bytes");
+
+// Tiles held as structure-of-arrays, in the same order as the file sections
+struct TileArrays {
+    uint32_t layout = LAYOUT_TILE_LIST;
+    int32_t boundingWidth = -1;
+    int32_t boundingHeight = -1;
+    int32_t lowerBound = 0;
+    std::vector<int32_t> partBegin{0};
+    std::vector<int32_t> width, height, offsetX, offsetY;
+    std::vector<int32_t> positionX;
+    std::vector<uint32_t> flags;
+
+    size_t tileCount() const { return positionX.size(); }
+    size_t partCount() const { return width.size(); }
+
+    void addPart(int w, int h, int dx, int dy) {
+        width.push_back(w);
+        height.push_back(h);
+        offsetX.push_back(dx);
+        offsetY.push_back(dy);
+    }
+
+    // Closes the tile made of the parts added since the previous endTile
+    void endTile(int x, uint32_t tileFlags) {
+        positionX.push_back(x);
+        flags.push_back(tileFlags);
+        partBegin.push_back(static_cast<int32_t>(width.size()));
+    }
+};
+
+// Outputs are written in the binary format when their name ends in .tpk
+inline bool hasTileFileExtension(const std::string& filename) {
+    return filename.size() >= 4 && filename.compare(filename.size() - 4, 4, ".tpk") == 0;
+}
+
+// Checks the magic bytes, so loaders can accept either format
+inline bool isTileFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    char magic[4];
+    return file.read(magic, 4) && std::memcmp(magic, TILE_FILE_MAGIC, 4) == 0;
+}
+
+inline bool writeTileFile(const std::string& filename, const TileArrays& tiles) {
+    std::ofstream out(filename, std::ios::binary);
+    if (!out) {
+        std::cerr << "Failed to open output file: " << filename << "\n";
+        return false;
+    }
+
+    TileFileHeader header{};
+    std::memcpy(header.magic, TILE_FILE_MAGIC, 4);
+    header.version = TILE_FILE_VERSION;
+    header.layout = tiles.layout;
+    header.tileCount = static_cast<uint32_t>(tiles.tileCount());
+    header.partCount = static_cast<uint32_t>(tiles.partCount());
+    header.boundingWidth = tiles.boundingWidth;
+    header.boundingHeight = tiles.boundingHeight;
+    header.lowerBound = tiles.lowerBound;
+
+    auto writeArray = [&out](const auto& values) {
+        out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(values[0]));
+    };
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeArray(tiles.partBegin);
+    writeArray(tiles.width);
+    writeArray(tiles.height);
+    writeArray(tiles.offsetX);
+    writeArray(tiles.offsetY);
+    writeArray(tiles.positionX);
+    writeArray(tiles.flags);
+    return static_cast<bool>(out);
+}
+
+// A whole file mapped read-only into memory. An empty file maps to an empty
+// range, so text readers treat it like any other; the .tpk view rejects it.
+class MappedFile {
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    // False if the file cannot be opened or mapped
+    bool open(const std::string& filename) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            close();
+            return false;
+        }
+        if (fileSize.QuadPart == 0) return true;
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data = mapping ? static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (!data) {
+            close();
+            return false;
+        }
+        length = static_cast<size_t>(fileSize.QuadPart);
+        return true;
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        if (st.st_size == 0) {
+            ::close(fd);
+            return true;
+        }
+        void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+        data = static_cast<const char*>(mapped);
+        length = static_cast<size_t>(st.st_size);
+        return true;
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        file = INVALID_HANDLE_VALUE;
+        mapping = nullptr;
+#else
+        if (data) munmap(const_cast<char*>(data), length);
+#endif
+        data = nullptr;
+        length = 0;
+    }
+
+    const char* begin() const { return data; }
+    const char* end() const { return data + length; }
+    size_t size() const { return length; }
+};
+
+// Read-only view of a .tpk file mapped into memory. The arrays point straight
+// into the mapping and stay valid while the view is alive.
+class TileFileView {
+private:
+    MappedFile file;
+
+    void unmap() {
+        file.close();
+        header = nullptr;
+    }
+
+public:
+    const TileFileHeader* header = nullptr;
+    const int32_t* partBegin = nullptr;
+    const int32_t* width = nullptr;
+    const int32_t* height = nullptr;
+    const int32_t* offsetX = nullptr;
+    const int32_t* offsetY = nullptr;
+    const int32_t* positionX = nullptr;
+    const uint32_t* flags = nullptr;
+
+    TileFileView() = default;
+    TileFileView(const TileFileView&) = delete;
+    TileFileView& operator=(const TileFileView&) = delete;
+    ~TileFileView() { unmap(); }
+
+    bool open(const std::string& filename) {
+        unmap();
+        if (!file.open(filename)) {
+            std::cerr << "Failed to map tile file: " << filename << "\n";
+            return false;
+        }
+
+        header = reinterpret_cast<const TileFileHeader*>(file.begin());
+        if (file.size() < sizeof(TileFileHeader) || std::memcmp(header->magic, TILE_FILE_MAGIC, 4) != 0) {
+            std::cerr << "Not a tile file: " << filename << "\n";
+            unmap();
+            return false;
+        }
+        if (header->version != TILE_FILE_VERSION) {
+            std::cerr << "Unsupported tile file version " << header->version << ": " << filename << "\n";
+            unmap();
+            return false;
+        }
+
+        size_t tiles = header->tileCount, parts = header->partCount;
+        size_t expected = sizeof(TileFileHeader) + 4 * ((tiles + 1) + 4 * parts + 2 * tiles);
+        if (file.size() < expected) {
+            std::cerr << "Truncated tile file: " << filename << "\n";
+            unmap();
+            return false;
+        }
+
+        const int32_t* cursor = reinterpret_cast<const int32_t*>(file.begin() + sizeof(TileFileHeader));
+        partBegin = cursor;  cursor += tiles + 1;
+        width = cursor;      cursor += parts;
+        height = cursor;     cursor += parts;
+        offsetX = cursor;    cursor += parts;
+        offsetY = cursor;    cursor += parts;
+        positionX = cursor;  cursor += tiles;
+        flags = reinterpret_cast<const uint32_t*>(cursor);
+
+        if (partBegin[0] != 0 || partBegin[tiles] != static_cast<int32_t>(parts)) {
+            std::cerr << "Corrupt part index in tile file: " << filename << "\n";
+            unmap();
+            return false;
+        }
+        for (size_t i = 0; i < tiles; ++i) {
+            if (partBegin[i + 1] < partBegin[i]) {
+                std::cerr << "Corrupt part index in tile file: " << filename << "\n";
+                unmap();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t tileCount() const { return header ? header->tileCount : 0; }
+    int partCount(size_t tile) const { return partBegin[tile + 1] - partBegin[tile]; }
+};
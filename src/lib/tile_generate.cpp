@@ -0,0 +1,210 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "tile_packing.h"
+#include "tile_generation.h"
+#include "module_packing.h"
+
+// Generates the circuit tiles of an excitation file in memory, optionally
+// splits them at one or two seams, and either writes them out for the
+// packers or packs them right away:
+//
+//   tile_generate excitations_distance=1.5.json test_tiles.txt --epsilon 0.001
+//   tile_generate excitations.json inter_intra_tiles.txt --seam 6 --ratio 4
+//   tile_generate excitations.json all_tiles.tpk --seam 4 --seam 8 --ratio 4 --pack
+//   tile_generate excitations.json all_tiles.txt --seam 4:6 --seam 8:6:2 --seam 12 --modules
+//
+// The excitation file is excitations_distance=*.json, or the output of
+// export_excitation_data() in tile_process.py when gradients are needed for
+// --epsilon. With one seam the order is inter then intra tiles (tile_expanding),
+// with two it is process_tiles'; --sorted stable-sorts by area afterwards.
+// Without --pack the tiles are written as a tile list, or in the
+// interTile/intraTile layout when seams are given (text, or .tpk by extension).
+// A text tile list writes copies of a tile in a row once, as "1*8".
+// An output of - writes the text to stdout, e.g. for tile_packing --stream,
+// or with --pack and --modules the placements (without a stats file).
+//
+// --modules packs a device of any number of modules instead (module_packing.h):
+// each --seam row[:separation[:ratio]] gets its own separation and ratio
+// (default 0 and --ratio), the modules are packed in parallel and the
+// inter-module tiles placed afterwards, seam by seam.
+
+static std::vector<int> parseList(const std::string& text) {
+    std::vector<int> values;
+    std::istringstream iss(text);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        values.push_back(std::stoi(item));
+    }
+    return values;
+}
+
+// row[:separation[:ratio]]
+static Seam parseSeam(const std::string& text, int ratio) {
+    std::vector<int> values;
+    std::istringstream iss(text);
+    std::string item;
+    while (std::getline(iss, item, ':')) {
+        values.push_back(std::stoi(item));
+    }
+    Seam seam{values.at(0)};
+    seam.separation = values.size() > 1 ? values[1] : 0;
+    seam.ratio = values.size() > 2 ? values[2] : ratio;
+    return seam;
+}
+
+static bool writeTiles(const std::string& filename, const std::vector<Tile>& tiles, bool interIntra) {
+    if (hasTileFileExtension(filename)) {
+        TileArrays out;
+        out.layout = interIntra ? LAYOUT_INTER_INTRA : LAYOUT_TILE_LIST;
+        for (const auto& tile : tiles) {
+            for (const auto& part : tile.parts) {
+                out.addPart(part.width, part.height, part.offsetX, part.offsetY);
+            }
+            out.endTile(0, tile.isInter ? uint32_t(TILE_INTER) : 0u);
+        }
+        return writeTileFile(filename, out);
+    }
+
+    std::ofstream file;
+    if (filename != "-") {
+        file.open(filename);
+        if (!file) {
+            std::cerr << "Failed to open output file: " << filename << "\n";
+            return false;
+        }
+    }
+    std::ostream& out = filename == "-" ? std::cout : file;
+    for (size_t i = 0, next; i < tiles.size(); i = next) {
+        const Tile& tile = tiles[i];
+        next = i + 1;
+        if (interIntra) {
+            out << (tile.isInter ? "interTile" : "intraTile") << "\n";
+        } else {
+            // Copies of a tile in a row share one entry, "parts*copies"
+            while (next < tiles.size() && tiles[next].sameShape(tile)) ++next;
+            out << tile.parts.size();
+            if (next - i > 1) out << "*" << next - i;
+            out << "\n";
+        }
+        for (const auto& part : tile.parts) {
+            out << part.width << " " << part.height << " " << part.offsetX << " " << part.offsetY << "\n";
+        }
+    }
+    return true;
+}
+
+// Writes the placements to output, or to stdout when it is -
+template <typename Packer>
+static void exportPacking(const Packer& packer, const std::string& output) {
+    if (output == "-") {
+        packer.exportResults(std::cout);
+        return;
+    }
+    packer.exportResults(output);
+    exportPackStats(output);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: tile_generate <excitations.json> <output> [--epsilon E] [--f-orbs n,n,...]"
+                     " [--seam S] [--seam S] [--ratio R] [--sorted] [--pack]\n"
+                     "       tile_generate <excitations.json> <output> --seam S[:sep[:ratio]] ... --modules\n";
+        return -1;
+    }
+    const std::string input = argv[1];
+    const std::string output = argv[2];
+
+    double epsilon = -1;  // Keeps excitations without a gradient too
+    std::vector<int> fOrbs;
+    std::vector<std::string> seamArgs;
+    int ratio = 1;
+    bool sortByArea = false, pack = false, modules = false;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--sorted") {
+            sortByArea = true;
+        } else if (arg == "--pack") {
+            pack = true;
+        } else if (arg == "--modules") {
+            modules = true;
+        } else if (i + 1 < argc && arg == "--epsilon") {
+            epsilon = std::stod(argv[++i]);
+        } else if (i + 1 < argc && arg == "--f-orbs") {
+            fOrbs = parseList(argv[++i]);
+        } else if (i + 1 < argc && arg == "--seam") {
+            seamArgs.push_back(argv[++i]);
+        } else if (i + 1 < argc && arg == "--ratio") {
+            ratio = std::stoi(argv[++i]);
+        } else {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return -1;
+        }
+    }
+    std::vector<Seam> moduleSeams;
+    std::vector<int> seams;
+    for (const auto& text : seamArgs) {
+        moduleSeams.push_back(parseSeam(text, ratio));
+        seams.push_back(moduleSeams.back().row);
+    }
+    if (seams.size() > 2 && !modules) {
+        std::cerr << "At most two seams are supported without --modules.\n";
+        return -1;
+    }
+
+    std::vector<Excitation> excitations;
+    if (readExcitations(input, excitations) != 0) {
+        return -1;
+    }
+
+    int skipped = 0;
+    std::vector<Tile> tiles = generateTiles(excitations, epsilon, fOrbs, nullptr, &skipped);
+    if (skipped > 0) {
+        std::cerr << "Skipped " << skipped << " excitations that are neither single nor double.\n";
+    }
+    // Progress goes to stderr when stdout carries the tiles or placements
+    std::ostream& log = output == "-" ? std::cerr : std::cout;
+    log << "Generated " << tiles.size() << " tiles from " << excitations.size() << " excitations\n";
+
+    if (modules) {
+        ModulePacking packing = packModules(tiles, moduleSeams, sortByArea);
+        if (!packing.complete) {
+            std::cerr << "Error: Tile doesn't fit, increase grid size.\n";
+        }
+        for (size_t module = 0; module < packing.moduleWidths.size(); ++module) {
+            log << "Module " << module << " intra width: " << packing.moduleWidths[module] << "\n";
+        }
+        const ModulePacker& packer = packing.packer;
+        log << "Bounding width: " << packer.getBoundingWidth() << "\n";
+        printLowerBounds(packer.getBoundingWidth(), packer.lowerBounds(), log);
+        exportPacking(packer, output);
+        return 0;
+    }
+
+    if (seams.size() == 1) {
+        tiles = splitAndExpand(tiles, seams[0], ratio, sortByArea);
+    } else if (seams.size() == 2) {
+        tiles = processTiles(tiles, ratio, std::min(seams[0], seams[1]), std::max(seams[0], seams[1]), sortByArea);
+    } else if (sortByArea) {
+        tiles = splitAndExpand(tiles, 0, 1, true);
+    }
+
+    if (!pack) {
+        if (!writeTiles(output, tiles, !seams.empty())) {
+            return -1;
+        }
+        log << "Tiles written to: " << output << "\n";
+        return 0;
+    }
+
+    TilePacker<DefaultGrid> packer(tiles, makeDefaultGrid());
+    if (!packer.packTiles()) {
+        std::cerr << "Error: Tile doesn't fit, increase grid size.\n";
+    }
+    log << "Bounding width: " << packer.getBoundingWidth() << "\n";
+    printLowerBounds(packer.getBoundingWidth(), packer.lowerBounds(), log);
+    exportPacking(packer, output);
+    return 0;
+}
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "tile.h"
+#include "seam_sweep.h"
+
+// Circuit tiles generated from the excitations directly, instead of through
+// create_circuit_tile / orbital_reordering / split_grid / process_tiles in
+// tile_process.py and a text export. Tiles, copies and order match the
+// Python functions.
+
+struct Excitation {
+    std::vector<int> a;  // Annihilated orbitals, 1 (single) or 2 (double)
+    std::vector<int> i;  // Created orbitals, as many as a
+    double gradient = std::numeric_limits<double>::infinity();  // Infinite when not known
+};
+
+// Nested JSON arrays of numbers, all the excitation files contain
+struct JsonArray {
+    double number = 0;
+    bool isArray = false;
+    std::vector<JsonArray> items;
+};
+
+inline bool parseJsonArray(const std::string& text, size_t& pos, JsonArray& value) {
+    while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+    if (pos >= text.size()) return false;
+
+    if (text[pos] != '[') {
+        const char* begin = text.c_str() + pos;
+        char* end;
+        value.number = std::strtod(begin, &end);
+        if (end == begin) return false;
+        pos += end - begin;
+        return true;
+    }
+
+    value.isArray = true;
+    ++pos;
+    while (true) {
+        while (pos < text.size() && std::isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+        if (pos < text.size() && text[pos] == ']') {
+            ++pos;
+            return true;
+        }
+        if (!value.items.empty()) {
+            if (pos >= text.size() || text[pos] != ',') return false;
+            ++pos;
+        }
+        value.items.emplace_back();
+        if (!parseJsonArray(text, pos, value.items.back())) return false;
+    }
+}
+
+// Reads excitations from JSON: a list of [a, i] pairs as in
+// excitations_distance=*.json, or of [a, i, gradient] triples as written by
+// export_excitation_data() in tile_process.py
+inline int readExcitations(const std::string& filename, std::vector<Excitation>& excitations) {
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "Failed to open file: " << filename << "\n";
+        return -1;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    JsonArray root;
+    size_t pos = 0;
+    if (!parseJsonArray(text, pos, root) || !root.isArray) {
+        std::cerr << "Invalid excitation file: " << filename << "\n";
+        return -1;
+    }
+
+    auto indices = [](const JsonArray& list, std::vector<int>& out) {
+        if (!list.isArray) return false;
+        for (const auto& item : list.items) {
+            if (item.isArray) return false;
+            out.push_back(static_cast<int>(item.number));
+        }
+        return true;
+    };
+
+    for (const auto& entry : root.items) {
+        Excitation excitation;
+        if (!entry.isArray || entry.items.size() < 2 || entry.items.size() > 3
+            || !indices(entry.items[0], excitation.a) || !indices(entry.items[1], excitation.i)) {
+            std::cerr << "Invalid excitation in " << filename << "\n";
+            return -1;
+        }
+        if (entry.items.size() == 3) {
+            excitation.gradient = std::abs(entry.items[2].number);
+        }
+        excitations.push_back(std::move(excitation));
+    }
+    return 0;
+}
+
+// orbital_reordering: interleaves the fragments' alpha and beta orbitals.
+// Like the Python version, only the first fragment size is used.
+inline void orbitalReordering(Excitation& excitation, const std::vector<int>& fOrbs) {
+    if (fOrbs.empty() || fOrbs.front() <= 0) return;
+    const int n = fOrbs.front();
+    int total = 0;
+    for (int orbitals : fOrbs) total += orbitals;
+
+    for (auto* pair : {&excitation.a, &excitation.i}) {
+        for (int& orbital : *pair) {
+            if (orbital < total) {
+                orbital = (orbital / n) * 2 * n + orbital % n;
+            } else {
+                orbital = ((orbital - total) / n) * 2 * n + orbital % n + n;
+            }
+        }
+    }
+}
+
+// create_circuit_tile for one excitation: two copies of a single-excitation
+// tile, two copies each of the two tiles of a double excitation sharing an
+// orbital, or eight copies of the tile of any other double excitation.
+// Returns false for excitations of any other shape.
+inline bool appendCircuitTiles(const Excitation& excitation, std::vector<Tile>& tiles) {
+    auto append = [&tiles](int copies, int w, int h, int dy) {
+        for (int c = 0; c < copies; ++c) {
+            tiles.emplace_back(std::vector<TilePart>{TilePart(w, h, 0, dy)});
+        }
+    };
+
+    if (excitation.a.size() == 1 && excitation.i.size() == 1) {
+        int i1 = std::min(excitation.a[0], excitation.i[0]);
+        int i2 = std::max(excitation.a[0], excitation.i[0]);
+        append(2, (i2 - i1) * 2, i2 - i1, i1);
+        return true;
+    }
+    if (excitation.a.size() != 2 || excitation.i.size() != 2) {
+        return false;
+    }
+
+    std::vector<int> a = excitation.a, i = excitation.i;
+    std::sort(a.begin(), a.end());
+    std::sort(i.begin(), i.end());
+    std::vector<int> common, different;
+    std::set_intersection(a.begin(), a.end(), i.begin(), i.end(), std::back_inserter(common));
+    std::set_symmetric_difference(a.begin(), a.end(), i.begin(), i.end(), std::back_inserter(different));
+
+    if (common.empty()) {
+        std::vector<int> index = {a[0], a[1], i[0], i[1]};
+        std::sort(index.begin(), index.end());
+        append(8, (index[1] - index[0]) * 2 + (index[3] - index[2]) * 2 + 2, index[3] - index[0], index[0]);
+        return true;
+    }
+    if (common.size() != 1 || different.size() != 2) {
+        return false;
+    }
+
+    const int j = common[0], i1 = different[0], i2 = different[1];
+    if (j < i1) {
+        append(2, (i2 - i1) * 2 + 2, i2 - j, j);
+    } else if (j > i2) {
+        append(2, (i2 - i1) * 2 + 2, j - i1, i1);
+    } else {
+        append(2, (j - 1 - i1) * 2 + 2 + (i2 - (j + 1)) * 2, i2 - i1, i1);
+    }
+    append(2, (i2 - i1) * 2, i2 - i1, i1);
+    return true;
+}
+
+// create_gradient_tiles: the tiles of every excitation with |gradient| >
+// epsilon, in excitation order, after orbital reordering when fOrbs is not
+// empty. gradients, if given, receives each tile's excitation gradient;
+// skipped, if given, counts the excitations appendCircuitTiles rejected.
+inline std::vector<Tile> generateTiles(const std::vector<Excitation>& excitations, double epsilon,
+                                       const std::vector<int>& fOrbs = {},
+                                       std::vector<double>* gradients = nullptr, int* skipped = nullptr) {
+    std::vector<Tile> tiles;
+    if (skipped) *skipped = 0;
+    for (const auto& source : excitations) {
+        if (!(source.gradient > epsilon)) continue;
+
+        Excitation excitation = source;
+        orbitalReordering(excitation, fOrbs);
+        size_t before = tiles.size();
+        if (!appendCircuitTiles(excitation, tiles)) {
+            if (skipped) ++*skipped;
+            continue;
+        }
+        if (gradients) {
+            gradients->insert(gradients->end(), tiles.size() - before, source.gradient);
+        }
+    }
+    return tiles;
+}
+
+// process_tiles for two seams: inter tiles of each seam widened by
+// 2 * (ratio - 1) and marked isInter, intra tiles split into the bands below,
+// between and above the seams, each band and seam sorted by its key. A tile
+// crossing both seams is packed once per seam, as in split_grid.
+inline std::vector<Tile> processTiles(const std::vector<Tile>& tiles, int ratio, int lowSeam, int highSeam,
+                                      bool sortByArea) {
+    std::vector<Tile> interDown, interUp, intraDown, intraMid, intraUp;
+    for (const auto& tile : tiles) {
+        if (tile.parts.empty()) continue;
+        const TilePart& first = tile.parts.front();
+        bool crossed = false;
+        for (int s = 0; s < 2; ++s) {
+            int seam = s == 0 ? lowSeam : highSeam;
+            if (first.offsetY < seam && first.offsetY + first.height >= seam) {
+                std::vector<Tile>& inter = s == 0 ? interDown : interUp;
+                inter.push_back(tile);
+                inter.back().isInter = true;
+                inter.back().parts.front().width += 2 * (ratio - 1);
+                crossed = true;
+            }
+        }
+        if (crossed) continue;
+        if (first.offsetY + first.height < lowSeam) {
+            intraDown.push_back(tile);
+        } else if (first.offsetY >= highSeam) {
+            intraUp.push_back(tile);
+        } else {
+            intraMid.push_back(tile);
+        }
+    }
+
+    auto sortBy = [](std::vector<Tile>& band, auto&& less) { std::stable_sort(band.begin(), band.end(), less); };
+    auto y = [](const Tile& t) { return t.parts.front().offsetY; };
+    auto h = [](const Tile& t) { return t.parts.front().height; };
+    auto w = [](const Tile& t) { return t.parts.front().width; };
+
+    sortBy(intraUp, [&](const Tile& a, const Tile& b) { return y(a) < y(b); });
+    sortBy(intraMid, [&](const Tile& a, const Tile& b) {
+        return (y(a) + h(a)) * y(a) > (y(b) + h(b)) * y(b);
+    });
+    sortBy(intraDown, [&](const Tile& a, const Tile& b) {
+        if (y(a) + h(a) != y(b) + h(b)) return y(a) + h(a) < y(b) + h(b);
+        return y(a) < y(b);
+    });
+    sortBy(interDown, [&](const Tile& a, const Tile& b) {
+        if (h(a) + y(a) != h(b) + y(b)) return h(a) + y(a) > h(b) + y(b);
+        return h(a) > h(b);
+    });
+    sortBy(interUp, [&](const Tile& a, const Tile& b) {
+        if (h(a) != h(b)) return h(a) < h(b);
+        return w(a) < w(b);
+    });
+
+    std::vector<Tile> intra = intraUp;
+    intra.insert(intra.end(), intraMid.begin(), intraMid.end());
+    intra.insert(intra.end(), intraDown.begin(), intraDown.end());
+
+    // Inter tiles go first when they outnumber the intra tiles
+    std::vector<Tile> ordered;
+    if (intra.size() < interDown.size() + interUp.size()) {
+        ordered = interUp;
+        ordered.insert(ordered.end(), interDown.begin(), interDown.end());
+        ordered.insert(ordered.end(), intra.begin(), intra.end());
+    } else {
+        ordered = intra;
+        ordered.insert(ordered.end(), interDown.begin(), interDown.end());
+        ordered.insert(ordered.end(), interUp.begin(), interUp.end());
+    }
+
+    if (sortByArea) {
+        auto area = [](const Tile& tile) {
+            int total = 0;
+            for (const auto& part : tile.parts) total += part.width * part.height;
+            return total;
+        };
+        std::stable_sort(ordered.begin(), ordered.end(),
+                         [&area](const Tile& a, const Tile& b) { return area(a) > area(b); });
+    }
+    return ordered;
+}
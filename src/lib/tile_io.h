@@ -0,0 +1,181 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include "tile_packing.h"
+#include "tile_file.h"
+#include "tile_text.h"
+
+// Readers for the input layouts shared by several executables. Each accepts
+// the text layout or a binary .tpk file; text is parsed into TileArrays
+// (tile_text.h), so both are read by the same loops over a TileFileView or
+// TileArrays ("Arrays").
+
+// Refills `parts`, so a loop over the tiles reuses one buffer
+template <typename Arrays>
+void readTileParts(const Arrays& view, size_t tile, std::vector<TilePart>& parts) {
+    parts.clear();
+    for (int p = view.partBegin[tile]; p < view.partBegin[tile + 1]; ++p) {
+        parts.emplace_back(view.width[p], view.height[p], view.offsetX[p], view.offsetY[p]);
+    }
+}
+
+template <typename Arrays>
+std::vector<TilePart> readTileParts(const Arrays& view, size_t tile) {
+    std::vector<TilePart> parts;
+    readTileParts(view, tile, parts);
+    return parts;
+}
+
+// True if tiles a and b of the file have the same parts
+template <typename Arrays>
+bool sameTileParts(const Arrays& view, size_t a, size_t b) {
+    int count = view.partBegin[a + 1] - view.partBegin[a];
+    if (view.partBegin[b + 1] - view.partBegin[b] != count) return false;
+    for (int i = 0; i < count; ++i) {
+        int p = view.partBegin[a] + i, q = view.partBegin[b] + i;
+        if (view.width[p] != view.width[q] || view.height[p] != view.height[q]
+            || view.offsetX[p] != view.offsetX[q] || view.offsetY[p] != view.offsetY[q]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline void reportUnplaced(const char* what, PartSpan parts) {
+    std::cerr << "Failed to place " << what << " tile: ";
+    for (const auto& part : parts) {
+        std::cerr << part.width << "x" << part.height << " ";
+    }
+    std::cerr << "\n";
+}
+
+template <typename Arrays>
+void appendTiles(const Arrays& view, std::vector<Tile>& tiles) {
+    tiles.reserve(tiles.size() + view.tileCount());
+    for (size_t i = 0; i < view.tileCount(); ++i) {
+        tiles.emplace_back(readTileParts(view, i));
+    }
+}
+
+// Reads tiles from a binary .tpk file
+inline int readBinaryTiles(const std::string& filename, std::vector<Tile>& tiles) {
+    PackPhase phase(PHASE_LOAD);
+    TileFileView view;
+    if (!view.open(filename)) {
+        return -1;
+    }
+    appendTiles(view, tiles);
+    return 0;
+}
+
+// Calls visit with the tiles of a .tpk file, or of a text file parsed by
+// parse(cursor, arrays); returns false if the file cannot be read. Tiles
+// parsed before a malformed line are still visited.
+template <typename Parse, typename Visit>
+bool withTileArrays(const std::string& filename, Parse&& parse, Visit&& visit) {
+    if (isTileFile(filename)) {
+        TileFileView view;
+        if (!view.open(filename)) {
+            return false;
+        }
+        visit(static_cast<const TileFileView&>(view));
+        return true;
+    }
+    TileArrays arrays;
+    bool parsed = parseTextFile(filename, arrays, parse);
+    visit(static_cast<const TileArrays&>(arrays));
+    return parsed;
+}
+
+// Calls onTile for every tile of a tile list (part count, then one
+// "w h dx dy" per part) as soon as it has been read, so a pipe can be
+// consumed while its producer is still writing. A part count of "n*k" stands
+// for k copies of the tile; onTile(tile, k) gets them in one call if it takes
+// a count, onTile(tile) is called k times otherwise. The tile passed is reused
+// for the next one, so reading allocates nothing per tile.
+template <typename OnTile>
+int forEachTile(std::istream& in, OnTile&& onTile) {
+    Tile tile(std::vector<TilePart>{});
+    std::vector<TilePart>& parts = tile.parts;
+    int partCount;
+    while (in >> partCount) {
+        if (partCount < 0) {
+            std::cerr << "Error reading tile part data.\n";
+            return -1;
+        }
+        int copies = readTileCopies(in);
+        if (copies == 0) {
+            return -1;
+        }
+        parts.clear();
+        for (int i = 0; i < partCount; ++i) {
+            int width, height, offsetX, offsetY;
+            if (!(in >> width >> height >> offsetX >> offsetY)) {
+                std::cerr << "Error reading tile part data.\n";
+                return -1;
+            }
+            parts.emplace_back(width, height, offsetX, offsetY);
+        }
+        if constexpr (std::is_invocable_v<OnTile, const Tile&, int>) {
+            onTile(static_cast<const Tile&>(tile), copies);
+        } else {
+            for (int copy = 0; copy < copies; ++copy) {
+                onTile(static_cast<const Tile&>(tile));
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Reads tiles from a file (text or binary .tpk) and stores them in a vector
+inline int readTiles(const std::string& filename, std::vector<Tile>& tiles) {
+    PackPhase phase(PHASE_LOAD);
+    bool read = withTileArrays(filename, readTileList, [&](const auto& view) { appendTiles(view, tiles); });
+    return read ? 0 : -1;
+}
+
+// Preplaced tiles, one "x w h dx dy" line each after an optional Bounding
+// Width header; in a .tpk file every tile is treated as preplaced at its
+// positionX
+template <typename Packer>
+void loadPreplacedTiles(Packer& packer, const std::string& filename) {
+    PackPhase phase(PHASE_LOAD);
+    withTileArrays(filename, readPlacements, [&](const auto& view) {
+        std::vector<TilePart> parts;
+        for (size_t i = 0; i < view.tileCount(); ++i) {
+            readTileParts(view, i, parts);
+            packer.addPreplacedTile(view.positionX[i], parts);
+        }
+    });
+}
+
+// Places `copies` copies of a free tile, reporting each that does not fit
+template <typename Packer>
+void placeFreeCopies(Packer& packer, const TileView& tile, int copies) {
+    int placed = packer.placeCopies(tile, copies, [](int) {});
+    for (int copy = placed; copy < copies; ++copy) {
+        reportUnplaced("free", tile.parts);
+    }
+}
+
+// Free tiles in the order given (tile list layout); runs of the same tile
+// are placed as copies
+template <typename Packer>
+void loadFreeTiles(Packer& packer, const std::string& filename) {
+    PackPhase phase(PHASE_LOAD);
+    withTileArrays(filename, readTileList, [&](const auto& view) {
+        std::vector<TilePart> parts;
+        for (size_t i = 0, next; i < view.tileCount(); i = next) {
+            readTileParts(view, i, parts);
+            for (next = i + 1; next < view.tileCount() && sameTileParts(view, i, next); ++next) {}
+            placeFreeCopies(packer, TileView(parts), static_cast<int>(next - i));
+        }
+    });
+}
@@ -1,189 +1,70 @@
 #include <iostream>
+#include <cctype>
 #include <vector>
 #include <fstream>
-#include <algorithm>
 #include <filesystem>
-
-#define MAX_WIDTH 10000000
-#define MAX_HEIGHT 100
-
-// Represents a part of a tile
-struct TilePart {
-    int width, height, offsetX, offsetY;
-    TilePart(int w, int h, int dx, int dy) : width(w), height(h), offsetX(dx), offsetY(dy) {}
-};
-
-// Represents a tile consisting of multiple parts
-class Tile {
-public:
-    std::vector<TilePart> parts;
-
-    explicit Tile(const std::vector<TilePart>& p) : parts(p) {}
-
-    // Function to print the tile's parts
-    void print() const {
-        std::cout << "Tile with " << parts.size() << " parts:\n";
-        for (const auto& part : parts) {
-            std::cout << "  Width: " << part.width
-                      << ", Height: " << part.height
-                      << ", OffsetX: " << part.offsetX
-                      << ", OffsetY: " << part.offsetY << '\n';
-        }
-    }
-};
-
-// Reads tiles from a file and stores them in a vector
-int readTiles(const std::string& filename, std::vector<Tile>& tiles) {
-    std::ifstream file(filename);
-    if (!file) {
-        std::cerr << "Failed to open file: " << filename << '\n';
-        return -1;
-    }
-
-    int partCount;
-    while (file >> partCount) {
-        std::vector<TilePart> parts;
-        for (int i = 0; i < partCount; ++i) {
-            int width, height, offsetX, offsetY;
-            if (!(file >> width >> height >> offsetX >> offsetY)) {
-                std::cerr << "Error reading tile part data.\n";
-                return -1;
-            }
-            parts.emplace_back(width, height, offsetX, offsetY);
-        }
-        tiles.emplace_back(parts);
-    }
-
-    return 0;
-}
-
-// Represents a placed tile with its position on the grid
-struct PlacedTile {
-    int positionX;
-    Tile tile;
-
-    PlacedTile(int x, Tile t) : positionX(x), tile(t) {}
-};
-
-// TilePacker class handles tile packing
-class TilePacker {
-private:
-    std::vector<Tile> tiles;
-    std::vector<std::vector<int>> grid;
-    std::vector<PlacedTile> placedTiles;  // Store information about placed tiles
-    int boundingWidth = 0;
-    int boundingHeight = 0;
-
-public:
-    explicit TilePacker(const std::vector<Tile>& t) : tiles(t) {
-        grid.resize(MAX_HEIGHT, std::vector<int>(MAX_WIDTH, 0));
-        calculateBoundingHeight();
-    }
-
-    void calculateBoundingHeight() {
-        for (const auto& tile : tiles) {
-            for (const auto& part : tile.parts) {
-                boundingHeight = std::max(boundingHeight, part.offsetY + part.height);
-            }
+#include <string>
+#include "tile_packing.h"
+#include "tile_io.h"
+
+// Streaming mode: tiles are read from stdin as a tile list and each placement
+// is written to stdout in the placed_tiles.txt line format as soon as it is
+// known, so the generator and the packer run side by side:
+//
+//   tile_generate excitations.json - | tile_packing --stream > placed_tiles.txt
+//
+// The bounding width and lower bound follow the last tile instead of preceding
+// the first. No tile is kept once it has been written out.
+//
+// --placement first|best|contact picks the placement policy (tile_packing.h)
+// in either mode; the default is first fit.
+template <typename Placement>
+static int streamPacking() {
+    std::ios::sync_with_stdio(false);
+    std::cin.tie(nullptr);
+
+    TilePacker<DefaultGrid, Placement> packer(makeDefaultGrid());
+    packer.setRecordPlacedTiles(false);
+    StreamingBounds bounds;
+    long long placed = 0, unplaced = 0;
+
+    PackPhase phase(PHASE_LOAD);
+    int status = forEachTile(std::cin, [&](const Tile& tile, int copies) {
+        int fitting = packer.placeCopies(tile, copies, [&](int x) {
+            bounds.add(tile);
+            writePlacedTileLine(std::cout, x, tile);
+            ++placed;
+        });
+        for (int copy = fitting; copy < copies; ++copy) {
+            reportUnplaced("free", tile.parts);
+            ++unplaced;
         }
-    }
-
-    bool fits(int x, const Tile& tile) {
-        for (const auto& part : tile.parts) {
-            int w = part.width, h = part.height, dx = part.offsetX, dy = part.offsetY;
-            if (x + dx + w > MAX_WIDTH) return false;
 
-            for (int row = dy; row < dy + h; ++row) {
-                for (int col = x + dx; col < x + dx + w; ++col) {
-                    if (grid[row][col] == 1) {  // Space is occupied
-                        return false;
-                    }
-                }
-            }
+        // Flush only when the next read would wait for the producer, so a
+        // fast producer is not slowed down by a write per tile. The line end
+        // after the tile is usually still buffered and does not count.
+        std::streambuf* input = std::cin.rdbuf();
+        while (input->in_avail() > 0 && std::isspace(input->sgetc())) {
+            input->sbumpc();
         }
-        return true;
-    }
-
-    int placeTile(const Tile& tile) {
-        for (int x = 0; x < MAX_WIDTH; ++x) {
-            if (fits(x, tile)) {
-                for (const auto& part : tile.parts) {
-                    for (int row = part.offsetY; row < part.offsetY + part.height; ++row) {
-                        for (int col = x + part.offsetX; col < x + part.offsetX + part.width; ++col) {
-                            grid[row][col] = 1;  // Mark the space as occupied
-                        }
-                    }
-                }
-
-                // Record the placed tile and its position
-                placedTiles.emplace_back(x, tile);
-                return x;  // Return the x position where the tile was placed
-            }
+        if (input->in_avail() <= 0) {
+            std::cout.flush();
         }
-        return -1;  // Tile could not be placed
+    });
+
+    std::cout << "Bounding Width: " << packer.getBoundingWidth() << '\n';
+    std::cout << "Lower Bound: " << bounds.bounds().best() << '\n';
+    std::cout.flush();
+    std::cerr << "Placed " << placed << " tiles";
+    if (unplaced > 0) {
+        std::cerr << ", " << unplaced << " did not fit";
     }
+    std::cerr << '\n';
+    return status;
+}
 
-    void packTiles() {
-        for (const auto& tile : tiles) {
-            int x_position = placeTile(tile);
-            if (x_position == -1) {
-                std::cerr << "Error: Tile doesn't fit, increase grid size.\n";
-                break;
-            }
-
-            for (const auto& part : tile.parts) {
-                boundingWidth = std::max(boundingWidth, x_position + part.offsetX + part.width);
-            }
-        }
-    }
-
-    void drawPacking() const {
-        std::cout << "Packing visualization:\n";
-        for (int i = 0; i < boundingHeight; ++i) {
-            for (int j = 0; j < boundingWidth; ++j) {
-                std::cout << (grid[i][j] ? "#" : ".");
-            }
-            std::cout << '\n';
-        }
-        std::cout << "Bounding width: " << boundingWidth << '\n';
-    }
-
-    void printPlacedTiles() const {
-        std::cout << "Placed Tiles (x, tiles):\n";
-        for (const auto& placedTile : placedTiles) {
-            std::cout << "x = " << placedTile.positionX << ", Tile:\n";
-            placedTile.tile.print();  // Print the details of the placed tile
-        }
-    }
-
-    // Export the placed tiles to a file
-    void exportPlacedTiles(const std::string& filename) const {
-        std::ofstream outFile(filename);
-        if (!outFile) {
-            std::cerr << "Failed to open file for writing: " << filename << '\n';
-            return;
-        }
-    
-        // Export the bounding width
-        outFile << "Bounding Width: " << boundingWidth << '\n';
-    
-        // Export the placed tiles
-        for (const auto& placedTile : placedTiles) {
-            outFile << placedTile.positionX << " ";  // x-coordinate of the placement
-            for (const auto& part : placedTile.tile.parts) {
-                outFile << part.width << " "
-                        << part.height << " "
-                        << part.offsetX << " "
-                        << part.offsetY << " ";  // Part details
-            }
-            outFile << '\n';  // New line after each tile
-        }
-    
-        std::cout << "Placed tiles and bounding width exported to: " << filename << '\n';
-    }    
-};
-
-int main() {
+template <typename Placement>
+static int filePacking() {
     std::vector<Tile> tiles;
 
     // Output the current working directory
@@ -205,53 +86,48 @@ int main() {
     }
 
     // Initialize tile packer and pack the tiles
-    TilePacker packer(tiles);
-    packer.packTiles();
+    TilePacker<DefaultGrid, Placement> packer(tiles, makeDefaultGrid());
+    if (!packer.packTiles()) {
+        std::cerr << "Error: Tile doesn't fit, increase grid size.\n";
+    }
 
     // Visualize the packed tiles
     packer.drawPacking();
 
     // Print the details of the placed tiles
     packer.printPlacedTiles();
+    printLowerBounds(packer.getBoundingWidth(), packer.lowerBounds());
+
     const char* output_path = "C:\\Users\\24835\\Desktop\\homework\\uiuc\\Covey\\chem\\H-chain\\placed_tiles.txt";
     // Export placed tiles to a file
     packer.exportPlacedTiles(output_path);
+    exportPackStats(output_path);
 
     return 0;
 }
 
-// extern "C" __declspec(dllexport) int run_packing(const char* filename) {
-//     std::vector<Tile> tiles;
-
-//     // Output the current working directory
-//     std::filesystem::path currentPath = std::filesystem::current_path();
-//     std::cout << "Current working directory: " << currentPath << '\n';
-
-//     // Read tile data from file in parent directory
-//     if (readTiles("../../test_tiles.txt", tiles) != 0) {
-//         return -1;
-//     }
-
-//     // Print the tiles after reading
-//     std::cout << "Tiles read from the file:\n";
-//     for (size_t i = 0; i < tiles.size(); ++i) {
-//         std::cout << "Tile " << i + 1 << ":\n";
-//         tiles[i].print();  // Print the current tile's parts
-//         std::cout << '\n';
-//     }
-
-//     // Initialize tile packer and pack the tiles
-//     TilePacker packer(tiles);
-//     packer.packTiles();
-
-//     // Visualize the packed tiles
-//     packer.drawPacking();
-
-//     // Print the details of the placed tiles
-//     packer.printPlacedTiles();
-
-//     // Export placed tiles to a file
-//     packer.exportPlacedTiles(filename);
+int main(int argc, char** argv) {
+    bool stream = false;
+    std::string placement = "first";
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--stream") {
+            stream = true;
+        } else if (i + 1 < argc && arg == "--placement") {
+            placement = argv[++i];
+        } else {
+            std::cerr << "Usage: tile_packing [--stream] [--placement first|best|contact]\n";
+            return -1;
+        }
+    }
 
-//     return 0;
-// }
+    int status = -1;
+    bool known = withPlacement(placement, [&](auto policy) {
+        using Placement = decltype(policy);
+        status = stream ? streamPacking<Placement>() : filePacking<Placement>();
+    });
+    if (!known) {
+        std::cerr << "Unknown placement: " << placement << "\n";
+    }
+    return status;
+}
@@ -0,0 +1,945 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include "occupancy_grid.h"
+#include "tile_file.h"
+#include "tile.h"
+#include "lower_bounds.h"
+#include "collision_index.h"
+
+#ifndef MAX_WIDTH
+#define MAX_WIDTH 10000000
+#endif
+#ifndef MAX_HEIGHT
+#define MAX_HEIGHT 100
+#endif
+
+// One packer serves all of the executables; each picks its behaviour at
+// compile time through three policies:
+//   Grid        - occupancy grid from occupancy_grid.h
+//   Placement   - how the x position of a free tile is searched for
+//   Constraint  - which cells a tile needs free and which it marks, e.g. the
+//                 separation inter-module tiles keep in double_packing
+// The x loop is instantiated per configuration, so the hot path never tests
+// which executable it is running in.
+
+// Grid used by the executables, the C API and the sweeps: the per-row
+// interval grid, whose memory grows with the number of placed runs rather
+// than the width. Define USE_FREE_RUN_GRID for the per-row free-run index
+// (O(log W) lookups in fragmented rows, but about 24 bytes per column of
+// every touched row), USE_DENSE_GRID or USE_COLUMN_MASK_GRID (tiles must
+// stay below row 64) to use one of the other grids; placements are identical.
+#if defined(USE_DENSE_GRID)
+using DefaultGrid = DenseGrid<bool>;
+inline DefaultGrid makeDefaultGrid() { return DefaultGrid(MAX_HEIGHT, MAX_WIDTH); }
+#elif defined(USE_FREE_RUN_GRID)
+using DefaultGrid = FreeRunGrid;
+inline DefaultGrid makeDefaultGrid() { return FreeRunGrid(MAX_HEIGHT); }
+#elif defined(USE_COLUMN_MASK_GRID)
+using DefaultGrid = ColumnMaskGrid;
+inline DefaultGrid makeDefaultGrid() { return ColumnMaskGrid(); }
+#else
+using DefaultGrid = IntervalGrid;
+inline DefaultGrid makeDefaultGrid() { return IntervalGrid(MAX_HEIGHT); }
+#endif
+
+// A grid plus, per row, the first column that is not known to be occupied.
+// `widen` extends every part of the tile to the right by that many columns.
+// Tiles are TileViews, or RectTiles for which the part loops compile away.
+template <typename Grid>
+class Occupancy {
+private:
+    Grid grid;
+    std::vector<int> firstFree;  // Per row, every column left of this one is occupied
+
+public:
+    explicit Occupancy(Grid g) : grid(std::move(g)), firstFree(MAX_HEIGHT, 0) {}
+
+    const Grid& cells() const { return grid; }
+
+    // Smallest x that is not ruled out by the per-row first free column hints
+    template <typename Shape>
+    int firstCandidate(const Shape& tile, int widen) const {
+        int x = 0;
+        for (const auto& part : tile.parts) {
+            if (part.width + widen <= 0 || part.offsetY + part.height > MAX_HEIGHT) continue;
+            for (int row = part.offsetY; row < part.offsetY + part.height; ++row) {
+                x = std::max(x, firstFree[row] - part.offsetX);
+            }
+        }
+        return x;
+    }
+
+    // On failure nextX is set to the smallest x that could still fit: the
+    // grid's next free position for the first blocked part, or MAX_WIDTH once
+    // the tile runs off the grid.
+    template <typename Shape>
+    bool fits(int x, const Shape& tile, int widen, int& nextX) const {
+        PACK_STATS_ADD(fitsCalls, 1);
+        for (const auto& part : tile.parts) {
+            int w = part.width + widen, h = part.height, dx = part.offsetX, dy = part.offsetY;
+            if (x + dx + w > MAX_WIDTH || dy + h > MAX_HEIGHT) {
+                nextX = MAX_WIDTH;
+                return false;
+            }
+
+            if (!grid.isFree(x + dx, dy, w, h)) {  // Space is occupied
+                nextX = grid.nextFit(x + dx, dy, w, h, MAX_WIDTH) - dx;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // For one part the grid's next free position is where the whole tile
+    // fits next, so it answers both questions in one search instead of an
+    // isFree that fails and a nextFit after it
+    bool fits(int x, const RectTile& tile, int widen, int& nextX) const {
+        PACK_STATS_ADD(fitsCalls, 1);
+        const TilePart& part = tile.parts[0];
+        int w = part.width + widen, h = part.height, dx = part.offsetX, dy = part.offsetY;
+        if (x + dx + w > MAX_WIDTH || dy + h > MAX_HEIGHT) {
+            nextX = MAX_WIDTH;
+            return false;
+        }
+        nextX = grid.nextFit(x + dx, dy, w, h, MAX_WIDTH) - dx;
+        return nextX == x;
+    }
+
+    template <typename Shape>
+    void occupy(int x, const Shape& tile, int widen) {
+        for (const auto& part : tile.parts) {
+            grid.occupy(x + part.offsetX, part.offsetY, part.width + widen, part.height);
+            for (int row = part.offsetY; row < part.offsetY + part.height; ++row) {
+                while (firstFree[row] < MAX_WIDTH && grid.occupied(row, firstFree[row])) {
+                    ++firstFree[row];
+                }
+            }
+        }
+    }
+
+    // Frees the tile's cells; rows whose first free column lay past them
+    // restart their hint at the tile
+    template <typename Shape>
+    void release(int x, const Shape& tile, int widen) {
+        for (const auto& part : tile.parts) {
+            grid.release(x + part.offsetX, part.offsetY, part.width + widen, part.height);
+            for (int row = part.offsetY; row < part.offsetY + part.height; ++row) {
+                firstFree[row] = std::min(firstFree[row], std::max(0, x + part.offsetX));
+            }
+        }
+    }
+
+    void clear() {
+        grid.clear();
+        std::fill(firstFree.begin(), firstFree.end(), 0);
+    }
+};
+
+// Constraint policies own the occupancy. withKind() resolves the kind of a
+// tile once and hands a tag to the visitor; fits/occupy/rightEdge are then
+// overloaded on the tag, so every kind gets its own copy of the x loop.
+// fitsSpan(x, span) holds when the tile fits at every position x .. x+span,
+// which is one widened fits check rather than span + 1 of them. The tile is
+// a TileView or a RectTile (Shape), each with its own copy of the code.
+
+// Every tile only needs its own cells to be free
+template <typename Grid>
+class NoSeparation {
+private:
+    Occupancy<Grid> occupancy;
+
+public:
+    struct AnyTile {};
+
+    explicit NoSeparation(Grid g) : occupancy(std::move(g)) {}
+
+    template <typename Shape, typename Visitor>
+    decltype(auto) withKind(const Shape&, Visitor&& visit) { return visit(AnyTile{}); }
+
+    template <typename Shape>
+    int firstCandidate(AnyTile, const Shape& tile) const { return occupancy.firstCandidate(tile, 0); }
+    template <typename Shape>
+    bool fits(AnyTile, int x, const Shape& tile, int& nextX) const { return occupancy.fits(x, tile, 0, nextX); }
+    template <typename Shape>
+    bool fitsSpan(AnyTile, int x, const Shape& tile, int span) const {
+        int nextX;
+        return occupancy.fits(x, tile, span, nextX);
+    }
+    template <typename Shape>
+    void occupy(AnyTile, int x, const Shape& tile) { occupancy.occupy(x, tile, 0); }
+    template <typename Shape>
+    void release(AnyTile, int x, const Shape& tile) { occupancy.release(x, tile, 0); }
+    template <typename Shape>
+    int rightEdge(AnyTile, int x, const Shape& tile) const { return x + tile.getTotalWidth(); }
+
+    const Grid& cells() const { return occupancy.cells(); }
+    void clear() { occupancy.clear(); }
+};
+
+// Double packing: intra tiles only need their own cells free, while inter
+// tiles need `separation` extra free columns to the right of every part, free
+// of other tiles and of other inter tiles' separations. One grid holds the
+// cells of every tile; the separations are kept apart as intervals, so the
+// cells are not stored twice, and an inter tile checks both.
+template <typename Grid>
+class InterSeparation {
+private:
+    Occupancy<Grid> occupancy;
+    IntervalGrid separations;  // Per row, the columns right of inter tile parts kept free
+
+    // Inter tile parts widened by `extra` columns past their separation
+    template <typename Shape>
+    bool fitsInter(int x, const Shape& tile, int extra, int& nextX) const {
+        if (!occupancy.fits(x, tile, tile.separation + extra, nextX)) {
+            return false;
+        }
+        for (const auto& part : tile.parts) {
+            int w = part.width + tile.separation + extra;
+            if (!separations.isFree(x + part.offsetX, part.offsetY, w, part.height)) {
+                nextX = separations.nextFit(x + part.offsetX, part.offsetY, w, part.height, MAX_WIDTH) - part.offsetX;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename Shape, typename Mark>
+    static void forEachSeparation(int x, const Shape& tile, Mark&& mark) {
+        if (tile.separation <= 0) return;
+        for (const auto& part : tile.parts) {
+            mark(x + part.offsetX + part.width, part.offsetY, tile.separation, part.height);
+        }
+    }
+
+public:
+    struct IntraTile {};
+    struct InterTile {};
+
+    explicit InterSeparation(Grid g) : occupancy(std::move(g)), separations(MAX_HEIGHT) {}
+
+    template <typename Shape, typename Visitor>
+    decltype(auto) withKind(const Shape& tile, Visitor&& visit) {
+        return tile.isInter ? visit(InterTile{}) : visit(IntraTile{});
+    }
+
+    template <typename Shape>
+    int firstCandidate(IntraTile, const Shape& tile) const { return occupancy.firstCandidate(tile, 0); }
+    template <typename Shape>
+    bool fits(IntraTile, int x, const Shape& tile, int& nextX) const { return occupancy.fits(x, tile, 0, nextX); }
+    template <typename Shape>
+    bool fitsSpan(IntraTile, int x, const Shape& tile, int span) const {
+        int nextX;
+        return occupancy.fits(x, tile, span, nextX);
+    }
+    template <typename Shape>
+    void occupy(IntraTile, int x, const Shape& tile) { occupancy.occupy(x, tile, 0); }
+    template <typename Shape>
+    void release(IntraTile, int x, const Shape& tile) { occupancy.release(x, tile, 0); }
+    template <typename Shape>
+    int rightEdge(IntraTile, int x, const Shape& tile) const { return x + tile.getTotalWidth(); }
+
+    // Columns left of the first free cell of a row cannot hold a widened part
+    // either, so the cell hints serve inter tiles too
+    template <typename Shape>
+    int firstCandidate(InterTile, const Shape& tile) const { return occupancy.firstCandidate(tile, tile.separation); }
+    template <typename Shape>
+    bool fits(InterTile, int x, const Shape& tile, int& nextX) const { return fitsInter(x, tile, 0, nextX); }
+    template <typename Shape>
+    bool fitsSpan(InterTile, int x, const Shape& tile, int span) const {
+        int nextX;
+        return fitsInter(x, tile, span, nextX);
+    }
+    template <typename Shape>
+    void occupy(InterTile, int x, const Shape& tile) {
+        occupancy.occupy(x, tile, 0);
+        forEachSeparation(x, tile, [&](int sx, int y, int w, int h) { separations.occupy(sx, y, w, h); });
+    }
+    template <typename Shape>
+    void release(InterTile, int x, const Shape& tile) {
+        occupancy.release(x, tile, 0);
+        forEachSeparation(x, tile, [&](int sx, int y, int w, int h) { separations.release(sx, y, w, h); });
+    }
+    template <typename Shape>
+    int rightEdge(InterTile, int x, const Shape& tile) const { return x + tile.getTotalWidth() + tile.separation; }
+
+    const Grid& cells() const { return occupancy.cells(); }
+    void clear() {
+        occupancy.clear();
+        separations.clear();
+    }
+};
+
+// What a placement policy may ask about the positions of one tile. Calling
+// it is the constraint's fits; slack, widens and contact serve the policies
+// that compare several fitting positions.
+template <typename Constraint, typename Kind, typename Shape>
+class Candidates {
+private:
+    const Constraint& constraint;
+    Kind kind;
+    Shape tile;
+    int frontier;  // Bounding width; cells and separations all end before it
+
+public:
+    Candidates(const Constraint& c, Kind k, const Shape& t, int bound)
+        : constraint(c), kind(k), tile(t), frontier(bound) {}
+
+    bool operator()(int x, int& nextX) const { return constraint.fits(kind, x, tile, nextX); }
+
+    // How far the tile, fitting at x, can slide right and still fit, or -1
+    // if it can slide past the frontier. Gallops, then bisects on span
+    // checks, so it costs log(slack) checks rather than slack.
+    int slack(int x) const {
+        int limit = frontier - x;
+        if (limit <= 0 || constraint.fitsSpan(kind, x, tile, limit)) {
+            return -1;
+        }
+        int fitting = 0, blocked = 1;
+        while (blocked < limit && constraint.fitsSpan(kind, x, tile, blocked)) {
+            fitting = blocked;
+            blocked *= 2;
+        }
+        blocked = std::min(blocked, limit);
+        while (blocked - fitting > 1) {
+            int mid = fitting + (blocked - fitting) / 2;
+            if (constraint.fitsSpan(kind, x, tile, mid)) {
+                fitting = mid;
+            } else {
+                blocked = mid;
+            }
+        }
+        return fitting;
+    }
+
+    // True if placing the tile at x grows the bounding width
+    bool widens(int x) const { return constraint.rightEdge(kind, x, tile) > frontier; }
+
+    // Occupied cells and grid edges next to the tile's cells at x
+    int contact(int x) const {
+        const auto& cells = constraint.cells();
+        int touching = 0;
+        for (const auto& part : tile.parts) {
+            int left = x + part.offsetX, right = left + part.width;
+            int top = part.offsetY, bottom = top + part.height;
+            for (int row = top; row < bottom; ++row) {
+                touching += (left == 0 || cells.occupied(row, left - 1));
+                touching += (right < MAX_WIDTH && cells.occupied(row, right));
+            }
+            for (int col = left; col < right; ++col) {
+                touching += (top == 0 || cells.occupied(top - 1, col));
+                touching += (bottom == MAX_HEIGHT || cells.occupied(bottom, col));
+            }
+        }
+        return touching;
+    }
+};
+
+// Placement policies. search() returns the x chosen by the policy, or -1 if
+// fits(x, nextX) holds nowhere below MAX_WIDTH; nextX is the next candidate
+// the constraint has not ruled out. Policies that only call fits also work
+// with a plain lambda in place of the Candidates.
+//
+// resumesCopies: the policy picks the leftmost fit, so the next copy of a
+// tile, which only sees more occupied cells, fits nowhere left of the copy
+// before it and can be searched for from there.
+
+// Leftmost x where the tile fits
+struct FirstFit {
+    static constexpr bool pushesPreplaced = false;
+    static constexpr bool resumesCopies = true;
+
+    template <typename Fits>
+    static int search(int x, Fits&& fits) {
+        while (x < MAX_WIDTH) {
+            int nextX;
+            if (fits(x, nextX)) {
+                return x;
+            }
+            if (nextX < MAX_WIDTH) PACK_STATS_ADD(skippedX, nextX - x - 1);
+            x = nextX;
+        }
+        return -1;
+    }
+};
+
+// First fit after pushing the preplaced tiles out of the new tile's way
+// (updated_tile_packing). Pushes can free cells left of a copy.
+struct PushPreplacedFirstFit : FirstFit {
+    static constexpr bool pushesPreplaced = true;
+    static constexpr bool resumesCopies = false;
+};
+
+// Visits the leftmost x of every run of fitting positions from x on, with
+// its slack, up to the run open towards the frontier or until visit returns
+// false. Runs are found with the constraint's jumps, never column by column.
+template <typename Fits, typename Visit>
+void forEachFittingRun(int x, const Fits& candidates, Visit&& visit) {
+    while ((x = FirstFit::search(x, candidates)) != -1) {
+        int slack = candidates.slack(x);
+        if (!visit(x, slack) || slack == -1) {
+            return;
+        }
+        x += slack + 1;
+    }
+}
+
+// Tightest gap: the tile goes left-aligned into the fitting run it can slide
+// least in, so narrow gaps between placed tiles are filled before the open
+// space past the packing. Ties go to the leftmost run.
+struct BestFit {
+    static constexpr bool pushesPreplaced = false;
+    static constexpr bool resumesCopies = false;
+
+    template <typename Fits>
+    static int search(int x, Fits&& candidates) {
+        int best = -1, bestSlack = -1;
+        forEachFittingRun(x, candidates, [&](int start, int slack) {
+            if (best == -1 || (slack != -1 && (bestSlack == -1 || slack < bestSlack))) {
+                best = start;
+                bestSlack = slack;
+            }
+            return bestSlack != 0;  // Nothing fits tighter
+        });
+        return best;
+    }
+};
+
+// Most contact: of both ends of every fitting run, the position whose cells
+// touch the most occupied cells and grid edges, so tiles nest against what is
+// already placed instead of leaving slivers. Positions that widen the packing
+// only win when nothing else fits; ties go to the leftmost.
+struct ContactFit {
+    static constexpr bool pushesPreplaced = false;
+    static constexpr bool resumesCopies = false;
+
+    template <typename Fits>
+    static int search(int x, Fits&& candidates) {
+        int best = -1, bestContact = 0;
+        bool bestWidens = true;
+        auto consider = [&](int candidate) {
+            bool widens = candidates.widens(candidate);
+            int contact = candidates.contact(candidate);
+            if (best == -1 || (!widens && bestWidens) || (widens == bestWidens && contact > bestContact)) {
+                best = candidate;
+                bestWidens = widens;
+                bestContact = contact;
+            }
+        };
+        forEachFittingRun(x, candidates, [&](int start, int slack) {
+            consider(start);
+            if (slack > 0) {
+                consider(start + slack);
+            }
+            return true;
+        });
+        return best;
+    }
+};
+
+// Calls visit with the placement policy named "first", "best" or "contact",
+// so executables pick one per run; returns false for any other name
+template <typename Visitor>
+bool withPlacement(const std::string& name, Visitor&& visit) {
+    if (name == "first") {
+        visit(FirstFit{});
+    } else if (name == "best") {
+        visit(BestFit{});
+    } else if (name == "contact") {
+        visit(ContactFit{});
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// One line of the placed_tiles.txt layout: x, then every part's w h dx dy
+inline void writePlacedTileLine(std::ostream& out, int x, const TileView& tile) {
+    out << x << " ";  // x-coordinate of the placement
+    for (const auto& part : tile.parts) {
+        out << part.width << " "
+            << part.height << " "
+            << part.offsetX << " "
+            << part.offsetY << " ";  // Part details
+    }
+    out << '\n';  // New line after each tile
+}
+
+// TilePacker class handles tile packing for every combination of policies
+template <typename Grid, typename Placement = FirstFit,
+          template <typename> class Constraint = NoSeparation>
+class TilePacker {
+private:
+    TileStore store;                  // Input tiles first, then preplaced and other placed tiles
+    size_t inputCount = 0;            // Tiles given to the constructor, packed by packTiles
+    Constraint<Grid> constraint;
+    std::vector<PlacedTile> placed;   // Preplaced and placed tiles as (store index, x)
+    int boundingWidth = 0;
+    int boundingHeight = 0;
+    bool recordPlacedTiles = true;
+    std::multimap<int, size_t> preplacedByEnd;  // Right edge -> index into placed
+    PartIndex partIndex;                        // Parts of the placed tiles, once partsIndexed
+    bool partsIndexed = false;
+
+    template <typename Shape>
+    void markOccupied(int x, const Shape& tile) {
+        constraint.withKind(tile, [&](auto kind) { constraint.occupy(kind, x, tile); });
+        boundingHeight = std::max(boundingHeight, tile.getTotalHeight());
+    }
+
+    TileView placedTile(size_t i) const { return getPlacedTiles()[i]; }
+
+    // True if the tile, at its positionX, overlaps any placed tile other than
+    // placed[self]. The part index is built on the first query and kept up to
+    // date from then on, so packers that never ask pay nothing for it.
+    bool doesTileCollideWithOthers(const TileView& tile, size_t self) {
+        if (!partsIndexed) {
+            for (size_t i = 0; i < placed.size(); ++i) {
+                partIndex.add(i, placedTile(i));
+            }
+            partsIndexed = true;
+        }
+        return partIndex.collides(tile, self);
+    }
+
+    // Records store[index] as placed at x, keeping the part index current
+    void recordPlacement(uint32_t index, int x) {
+        placed.push_back({index, x});
+        if (partsIndexed) {
+            partIndex.add(placed.size() - 1, placedTile(placed.size() - 1));
+        }
+    }
+
+    // Moves placed tiles, given as (index into placed, distance), and
+    // updates the occupancy only in the columns they covered: their cells are
+    // released, the other tiles reaching into those columns (preplaced tiles
+    // and separations may overlap them) are marked again, and the moved tiles
+    // are marked at their new positions
+    void shiftTiles(const std::vector<std::pair<size_t, int>>& moves) {
+        if (moves.empty()) return;
+        PACK_STATS_ADD(shiftedTiles, static_cast<long long>(moves.size()));
+
+        std::vector<bool> moved(placed.size(), false);
+        int from = MAX_WIDTH, to = 0;
+        for (const auto& [index, distance] : moves) {
+            TileView tile = placedTile(index);
+            constraint.withKind(tile, [&](auto kind) {
+                constraint.release(kind, tile.positionX, tile);
+                from = std::min(from, tile.positionX);
+                to = std::max(to, constraint.rightEdge(kind, tile.positionX, tile));
+            });
+            moved[index] = true;
+        }
+
+        for (size_t i = 0; i < placed.size(); ++i) {
+            if (moved[i]) continue;
+            TileView tile = placedTile(i);
+            constraint.withKind(tile, [&](auto kind) {
+                if (tile.positionX < to && constraint.rightEdge(kind, tile.positionX, tile) > from) {
+                    constraint.occupy(kind, tile.positionX, tile);
+                }
+            });
+        }
+
+        for (const auto& [index, distance] : moves) {
+            TileView tile = placedTile(index);
+            if (partsIndexed) partIndex.remove(index, tile);
+            placed[index].x += distance;
+            tile.positionX += distance;
+            if (partsIndexed) partIndex.add(index, tile);
+            markOccupied(tile.positionX, tile);
+            constraint.withKind(tile, [&](auto kind) {
+                boundingWidth = std::max(boundingWidth, constraint.rightEdge(kind, tile.positionX, tile));
+            });
+        }
+    }
+
+    void indexPreplacedTiles() {
+        preplacedByEnd.clear();
+        for (size_t i = 0; i < placed.size(); ++i) {
+            TileView tile = placedTile(i);
+            if (tile.isPreplaced) {
+                preplacedByEnd.emplace(tile.positionX + tile.getTotalWidth(), i);
+            }
+        }
+    }
+
+    // Function to push preplaced tiles dynamically to optimize packing. Only
+    // tiles ending past the new tile's x are in its way; they are looked up by
+    // their right edge instead of scanning every placed tile.
+    template <typename Shape>
+    void pushPreplacedTiles(const Shape& newTile) {
+        std::vector<std::pair<size_t, int>> moves;
+
+        // Try to push preplaced tiles forward to make room for the new tile
+        for (auto it = preplacedByEnd.upper_bound(newTile.positionX); it != preplacedByEnd.end(); ++it) {
+            int moveDistance = newTile.positionX - it->first;
+            if (moveDistance <= 0) {
+                break;  // Later tiles end further right and would move even less
+            }
+            if (moves.empty()) {
+                std::cout << "Pushing preplaced tiles to optimize packing for the new tile...\n";
+            }
+            std::cout << "Pushing tile at position " << placed[it->second].x
+                      << " forward by " << moveDistance << " units.\n";
+            moves.emplace_back(it->second, moveDistance);
+        }
+
+        // Update the occupancy around the pushed tiles
+        if (!moves.empty()) {
+            shiftTiles(moves);
+            indexPreplacedTiles();
+        }
+    }
+
+    // Places `copies` copies of the tile, which is store[index] if placements
+    // are recorded, see placeCopies. The store does not grow meanwhile, so
+    // the view stays valid. Single-part tiles, all the generator emits, take
+    // the RectTile instantiation of the search.
+    template <typename OnPlaced>
+    int placeRun(const TileView& tile, uint32_t index, int copies, OnPlaced&& onPlaced) {
+        PackPhase phase(PHASE_PACK);
+        if (tile.parts.size() == 1) {
+            return placeRunOf(RectTile(tile), index, copies, onPlaced);
+        }
+        return placeRunOf(tile, index, copies, onPlaced);
+    }
+
+    template <typename Shape, typename OnPlaced>
+    int placeRunOf(const Shape& tile, uint32_t index, int copies, OnPlaced& onPlaced) {
+        return constraint.withKind(tile, [&](auto kind) {
+            int previousX = 0;
+            for (int copy = 0; copy < copies; ++copy) {
+                if constexpr (Placement::pushesPreplaced) {
+                    pushPreplacedTiles(tile);
+                }
+
+                int start = constraint.firstCandidate(kind, tile);
+                if constexpr (Placement::resumesCopies) {
+                    if (copy > 0 && previousX > start) {
+                        PACK_STATS_ADD(resumedCopies, 1);
+                        start = previousX;
+                    }
+                }
+                Candidates<Constraint<Grid>, decltype(kind), Shape> candidates(constraint, kind, tile, boundingWidth);
+                int x = Placement::search(start, candidates);
+                if (x == -1) {
+                    return copy;  // Tile could not be placed
+                }
+
+                constraint.occupy(kind, x, tile);  // Mark the space as occupied
+                boundingWidth = std::max(boundingWidth, constraint.rightEdge(kind, x, tile));
+                boundingHeight = std::max(boundingHeight, tile.getTotalHeight());
+
+                // Record the placed tile and its position
+                if (recordPlacedTiles) {
+                    recordPlacement(index, x);
+                }
+                onPlaced(x);
+                previousX = x;
+            }
+            return copies;
+        });
+    }
+
+public:
+    explicit TilePacker(Grid g) : constraint(std::move(g)) {}
+
+    // Keeps the tiles in a TileStore and reserves their placement records up
+    // front, so packTiles allocates nothing per tile
+    TilePacker(const std::vector<Tile>& t, Grid g) : constraint(std::move(g)) {
+        size_t partCount = 0;
+        for (const auto& tile : t) {
+            partCount += tile.parts.size();
+        }
+        store.reserve(t.size(), partCount);
+        for (const auto& tile : t) {
+            store.add(tile);
+        }
+        inputCount = store.size();
+        placed.reserve(inputCount);
+    }
+
+    void addPreplacedTile(int x, int w, int h, int dx, int dy) {
+        TilePart part(w, h, dx, dy);
+        addPreplacedTile(x, PartSpan(&part, &part + 1));
+    }
+
+    void addPreplacedTile(int x, PartSpan parts) {
+        PackPhase phase(PHASE_PREPLACE);
+        TileView tile(parts, true, x);
+        markOccupied(x, tile);
+        boundingWidth = std::max(boundingWidth, x + tile.getTotalWidth());
+        preplacedByEnd.emplace(x + tile.getTotalWidth(), placed.size());
+        recordPlacement(store.add(tile), x);
+    }
+
+    // Records a free tile placed at x elsewhere, e.g. by a packer over other
+    // rows, without searching or checking for room
+    void addPlacedTile(int x, const TileView& tile) {
+        constraint.withKind(tile, [&](auto kind) {
+            constraint.occupy(kind, x, tile);
+            boundingWidth = std::max(boundingWidth, constraint.rightEdge(kind, x, tile));
+        });
+        boundingHeight = std::max(boundingHeight, tile.getTotalHeight());
+        if (recordPlacedTiles) {
+            recordPlacement(store.add(tile), x);
+        }
+    }
+
+    // Places a free tile where the placement policy puts it and returns its
+    // x, or -1 if it does not fit anywhere
+    int placeTile(const TileView& tile) {
+        int placedAt = -1;
+        placeCopies(tile, 1, [&](int x) { placedAt = x; });
+        return placedAt;
+    }
+
+    // Places `copies` copies of the tile in a row, calling onPlaced(x) for
+    // each, and returns how many fit; copies after one that does not fit are
+    // skipped. The kind is resolved once for the run, the tile is stored once
+    // for all of its copies, and with a policy that resumesCopies every copy
+    // is searched for from the previous one's x.
+    template <typename OnPlaced>
+    int placeCopies(const TileView& tile, int copies, OnPlaced&& onPlaced) {
+        if (!recordPlacedTiles) {
+            return placeRun(tile, 0, copies, onPlaced);
+        }
+        uint32_t index = store.add(tile);
+        int fitting = placeRun(store[index], index, copies, onPlaced);
+        if (fitting == 0) {
+            store.truncate(index);
+        }
+        return fitting;
+    }
+
+    // Stops (or resumes) keeping placed free tiles in getPlacedTiles(), for
+    // callers that write each placement out themselves and would otherwise
+    // hold every tile of a long stream. Lower bounds and exports then only
+    // cover the tiles still recorded.
+    void setRecordPlacedTiles(bool record) { recordPlacedTiles = record; }
+
+    // Places one tile after those already placed and grows the bounding width
+    bool addTile(const TileView& tile) {
+        return placeTile(tile) != -1;
+    }
+
+    // Returns false if a tile could not be placed; tiles after it are
+    // skipped. Runs of tiles of the same shape are placed as copies.
+    bool packTiles() {
+        for (size_t begin = 0, end; begin < inputCount; begin = end) {
+            TileView tile = store[begin];
+            for (end = begin + 1; end < inputCount && store[end].sameShape(tile); ++end) {}
+            int copies = static_cast<int>(end - begin);
+            if (placeRun(tile, static_cast<uint32_t>(begin), copies, [](int) {}) != copies) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Moves the preplaced tile at x by a, together with every placed tile at
+    // or right of x, if the tile does not collide at its new position
+    void movePreplacedTile(int x, int a) {
+        std::cout << "Attempting to push preplaced tile at position " << x << " by " << a << " units.\n";
+
+        for (size_t i = 0; i < placed.size(); ++i) {
+            TileView tile = placedTile(i);
+            if (tile.positionX == x && tile.isPreplaced) {
+                int newPosition = tile.positionX + a;
+
+                TileView tempTile = tile;
+                tempTile.positionX = newPosition;
+
+                if (!doesTileCollideWithOthers(tempTile, i)) {
+                    std::cout << "Tile at position " << x << " can be pushed. Moving it to position " << newPosition << ".\n";
+
+                    std::vector<std::pair<size_t, int>> moves;
+                    for (size_t j = 0; j < placed.size(); ++j) {
+                        if (j == i || placed[j].x >= x) {
+                            moves.emplace_back(j, a);
+                        }
+                    }
+
+                    shiftTiles(moves);
+                    indexPreplacedTiles();
+                    std::cout << "Grid updated after move.\n";
+                    return;
+                } else {
+                    std::cout << "Cannot push tile at position " << x << " due to collision.\n";
+                }
+            }
+        }
+    }
+
+    // Occupancy and bounding box without the placed tile list, which makes it
+    // much cheaper to copy than the packer for searches that rewind often
+    struct Snapshot {
+        Constraint<Grid> constraint;
+        int boundingWidth;
+        int boundingHeight;
+    };
+
+    Snapshot snapshot() const { return {constraint, boundingWidth, boundingHeight}; }
+
+    // Rewinds to a snapshot. The placed tile list is cleared, so afterwards it
+    // only holds the tiles placed since the restore.
+    void restore(const Snapshot& saved) {
+        constraint = saved.constraint;
+        boundingWidth = saved.boundingWidth;
+        boundingHeight = saved.boundingHeight;
+        placed.clear();
+        store.truncate(inputCount);
+        preplacedByEnd.clear();
+        partIndex.clear();
+        partsIndexed = false;
+    }
+
+    int getBoundingWidth() const { return boundingWidth; }
+    int getBoundingHeight() const { return boundingHeight; }
+
+    // Lower bounds for the tiles placed so far, see lower_bounds.h
+    WidthBounds lowerBounds() const { return computeLowerBounds(getPlacedTiles()); }
+
+    // Views of the placed tiles, invalidated by the next tile added
+    PlacedTileList getPlacedTiles() const { return PlacedTileList(store, placed); }
+
+    void drawPacking() const {
+        std::cout << "Packing visualization:\n";
+        for (int i = 0; i < boundingHeight; ++i) {
+            for (int j = 0; j < boundingWidth; ++j) {
+                std::cout << (constraint.cells().occupied(i, j) ? "#" : ".");
+            }
+            std::cout << '\n';
+        }
+        std::cout << "Bounding width: " << boundingWidth << '\n';
+    }
+
+    void visualize(int maxRows = 20, int maxCols = 80) const {
+        std::cout << "Packing visualization (" << boundingWidth << "x" << boundingHeight << "):\n";
+        int rowsToShow = std::min(boundingHeight, maxRows);
+        int colsToShow = std::min(boundingWidth, maxCols);
+
+        for (int y = 0; y < rowsToShow; ++y) {
+            for (int x = 0; x < colsToShow; ++x) {
+                std::cout << (constraint.cells().occupied(y, x) ? '#' : '.');
+            }
+            std::cout << "\n";
+        }
+    }
+
+    void printPlacedTiles() const {
+        std::cout << "Placed Tiles (x, tiles):\n";
+        for (const auto& placedTile : getPlacedTiles()) {
+            std::cout << "x = " << placedTile.positionX << ", Tile:\n";
+            placedTile.print();  // Print the details of the placed tile
+        }
+    }
+
+    // Export the placed tiles to a binary .tpk file
+    void exportPlacedTilesBinary(const std::string& filename) const {
+        PackPhase phase(PHASE_EXPORT);
+        TileArrays out;
+        out.layout = LAYOUT_PLACED;
+        out.boundingWidth = boundingWidth;
+        out.lowerBound = lowerBounds().best();
+        for (const auto& placedTile : getPlacedTiles()) {
+            for (const auto& part : placedTile.parts) {
+                out.addPart(part.width, part.height, part.offsetX, part.offsetY);
+            }
+            out.endTile(placedTile.positionX, TILE_PLACED);
+        }
+        if (writeTileFile(filename, out)) {
+            std::cout << "Placed tiles and bounding width exported to: " << filename << '\n';
+        }
+    }
+
+    // Export the placed tiles to a file (placed_tiles.txt layout), binary if
+    // its name ends in .tpk
+    void exportPlacedTiles(const std::string& filename) const {
+        PackPhase phase(PHASE_EXPORT);
+        if (hasTileFileExtension(filename)) {
+            exportPlacedTilesBinary(filename);
+            return;
+        }
+
+        std::ofstream outFile(filename);
+        if (!outFile) {
+            std::cerr << "Failed to open file for writing: " << filename << '\n';
+            return;
+        }
+
+        // Export the bounding width and the lower bound it can be compared with
+        outFile << "Bounding Width: " << boundingWidth << '\n';
+        outFile << "Lower Bound: " << lowerBounds().best() << '\n';
+
+        // Export the placed tiles
+        for (const auto& placedTile : getPlacedTiles()) {
+            writePlacedTileLine(outFile, placedTile.positionX, placedTile);
+        }
+
+        std::cout << "Placed tiles and bounding width exported to: " << filename << '\n';
+    }
+
+    void exportResultsBinary(const std::string& filename) const {
+        PackPhase phase(PHASE_EXPORT);
+        TileArrays out;
+        out.layout = LAYOUT_RESULT;
+        out.boundingWidth = boundingWidth;
+        out.boundingHeight = boundingHeight;
+        out.lowerBound = lowerBounds().best();
+        for (const auto& tile : getPlacedTiles()) {
+            for (const auto& part : tile.parts) {
+                out.addPart(part.width, part.height, part.offsetX, part.offsetY);
+            }
+            uint32_t flags = TILE_PLACED;
+            if (tile.isPreplaced) flags |= TILE_PREPLACED;
+            if (tile.isInter) flags |= TILE_INTER;
+            out.endTile(tile.positionX, flags);
+        }
+        writeTileFile(filename, out);
+    }
+
+    // Text results (all_tiles.txt / result_tiles.txt layout), or binary if the
+    // name ends in .tpk
+    void exportResults(const std::string& filename) const {
+        if (hasTileFileExtension(filename)) {
+            exportResultsBinary(filename);
+            return;
+        }
+
+        std::ofstream out(filename);
+        if (!out) {
+            std::cerr << "Failed to open output file: " << filename << "\n";
+            return;
+        }
+        exportResults(out);
+    }
+
+    // Text results written to a stream, e.g. std::cout
+    void exportResults(std::ostream& out) const {
+        PackPhase phase(PHASE_EXPORT);
+        out << "Bounding Width: " << boundingWidth << "\n";
+        out << "Bounding Height: " << boundingHeight << "\n";
+        out << "Lower Bound: " << lowerBounds().best() << "\n";
+
+        for (const auto& tile : getPlacedTiles()) {
+            if (tile.isPreplaced) {
+                out << "Preplaced " << tile.positionX << " ";
+            } else {
+                out << "Placed " << tile.positionX << " ";
+            }
+            for (const auto& part : tile.parts) {
+                out << part.width << " " << part.height << " "
+                    << part.offsetX << " " << part.offsetY << " ";
+            }
+            out << "\n";
+        }
+    }
+};
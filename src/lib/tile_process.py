@@ -37,6 +37,25 @@ def create_excitation(uop, all_g, epsilon):
             excitations.append(cur_excitation)
     return excitations
 
+def create_gradient_tiles(uop, all_g, epsilon, f_orbs = None):
+    """Tiles for every excitation with |gradient| > epsilon, each tagged with its |gradient|.
+
+    Same tiles and order as create_circuit_tile(create_excitation(...)); pass the
+    smallest epsilon of a sweep and let epsilon_sweep_with_lib filter the rest.
+    """
+    tiles = []
+    gradients = []
+    for [gradient, i] in all_g:
+        gradient = abs(gradient)
+        if gradient > epsilon:
+            excitation = [[uop.a_idxs[i].copy(), uop.i_idxs[i].copy()]]
+            if f_orbs is not None:
+                excitation = orbital_reordering(excitation, f_orbs)
+            cur_tiles = create_circuit_tile(excitation)
+            tiles += cur_tiles
+            gradients += [gradient] * len(cur_tiles)
+    return tiles, gradients
+
 def orbital_reordering(excitations, f_orbs):
     fragment = np.array(f_orbs)
     fragment = 2*fragment
@@ -188,11 +207,20 @@ def tile_expanding(k, ratio_lst, tiles, seam_lst, initial_time, twocut = False):
     print(f"END job {k} on thread {thread_id}")
     return initial_time, post_time
 
-def export_tiles_to_file(tiles, filename):
+def export_tiles_to_file(tiles, filename, runs = False):
+    """Write tiles as a tile list. With runs, copies of a tile in a row, as
+    create_circuit_tile emits them, are written once as "parts*copies",
+    which the packers place as one run."""
     with open(filename, "w") as f:
-        for tile in tiles:
+        i = 0
+        while i < len(tiles):
+            tile = tiles[i]
+            copies = 1
+            while runs and i + copies < len(tiles) and tiles[i + copies] == tile:
+                copies += 1
+            i += copies
             # Write the number of parts for this tile
-            f.write(f"{len(tile)}\n")
+            f.write(f"{len(tile)}*{copies}\n" if copies > 1 else f"{len(tile)}\n")
             for part in tile:
                 # Write each part's details: w h dx dy
                 f.write(f"{part[0]} {part[1]} {part[2]} {part[3]}\n")
@@ -216,23 +244,103 @@ def export_inter_intra(tiles, filename, seam_lst):
                     f.write(f"{part[0]} {part[1]} {part[2]} {part[3]}\n")
     print(f"Tiles successfully exported to {filename}")
 
+TILE_FILE_HEADER = np.dtype([("magic", "S4"), ("version", "<u4"), ("layout", "<u4"),
+                             ("tile_count", "<u4"), ("part_count", "<u4"),
+                             ("bounding_width", "<i4"), ("bounding_height", "<i4"), ("lower_bound", "<i4")])
+
+def export_tiles_to_binary(tiles, filename):
+    """Write tiles as a .tpk tile list (layout described in lib/tile_file.h)."""
+    part_counts = np.array([len(tile) for tile in tiles], dtype="<i4")
+    part_begin = np.concatenate(([0], np.cumsum(part_counts))).astype("<i4")
+    parts = np.array([part for tile in tiles for part in tile], dtype="<i4").reshape(-1, 4)
+    header = np.zeros(1, dtype=TILE_FILE_HEADER)
+    header["magic"] = b"TPKF"
+    header["version"] = 1
+    header["tile_count"] = len(tiles)
+    header["part_count"] = len(parts)
+    header["bounding_width"] = -1
+    header["bounding_height"] = -1
+    with open(filename, "wb") as f:
+        header.tofile(f)
+        part_begin.tofile(f)
+        for column in range(4):
+            np.ascontiguousarray(parts[:, column]).tofile(f)
+        np.zeros(2 * len(tiles), dtype="<i4").tofile(f)  # positionX and flags
+    print(f"Tiles successfully exported to {filename}")
+
+def export_excitation_data(uop, all_g, filename):
+    """Write the excitations of all_g as [a_idxs, i_idxs, gradient] JSON triples, in all_g order.
+
+    Input for lib/tile_generate, which builds the tiles natively; --epsilon then
+    filters by |gradient| like create_excitation.
+    """
+    excitations = [[[int(v) for v in uop.a_idxs[i]], [int(v) for v in uop.i_idxs[i]], float(gradient)]
+                   for gradient, i in all_g]
+    with open(filename, "w") as f:
+        json.dump(excitations, f)
+    print(f"Excitations successfully exported to {filename}")
+
+def export_benchmark_sets(data_dirs, out_dir):
+    """Export the tiles of every excitations_distance=*.json under data_dirs as .tpk tile lists.
+
+    Files are named <data dir>_e=<epsilon>_d=<distance>.tpk, the inputs lib/tile_benchmark
+    runs on, e.g. export_benchmark_sets(["../data_H_12", "../data_cr_2"], "bench_tiles").
+    Returns the exported file names.
+    """
+    os.makedirs(out_dir, exist_ok=True)
+    exported = []
+    for data_dir in data_dirs:
+        set_name = os.path.basename(os.path.normpath(data_dir))
+        for epsilon_dir in sorted(os.listdir(data_dir)):
+            for name in sorted(os.listdir(os.path.join(data_dir, epsilon_dir))):
+                if not (name.startswith("excitations_distance=") and name.endswith(".json")):
+                    continue
+                with open(os.path.join(data_dir, epsilon_dir, name), "r") as file:
+                    excitations = json.load(file)
+                distance = name[len("excitations_distance="):-len(".json")]
+                epsilon = epsilon_dir[len("data_e="):]
+                filename = os.path.join(out_dir, f"{set_name}_e={epsilon}_d={distance}.tpk")
+                export_tiles_to_binary(create_circuit_tile(excitations), filename)
+                exported.append(filename)
+    return exported
+
+def read_tile_file(filename):
+    """Read a .tpk file written by the packers; returns (bounding_width, placed_tiles)."""
+    data = np.fromfile(filename, dtype=np.uint8)
+    header = data[:TILE_FILE_HEADER.itemsize].view(TILE_FILE_HEADER)[0]
+    if header["magic"] != b"TPKF" or header["version"] != 1:
+        print("Error: not a version 1 tile file.")
+        return 0, []
+    tile_count = int(header["tile_count"])
+    part_count = int(header["part_count"])
+    body = data[TILE_FILE_HEADER.itemsize:].view("<i4")
+    part_begin = body[:tile_count + 1]
+    columns = body[tile_count + 1:tile_count + 1 + 4 * part_count].reshape(4, part_count)
+    position_x = body[tile_count + 1 + 4 * part_count:][:tile_count]
+
+    placed_tiles = []
+    for i in range(tile_count):
+        parts = [tuple(int(v) for v in columns[:, p]) for p in range(part_begin[i], part_begin[i + 1])]
+        placed_tiles.append((int(position_x[i]), parts))
+    return int(header["bounding_width"]), placed_tiles
+
 def read_placed_tiles(filename):
     placed_tiles = []
     bounding_width = 0
 
     try:
         with open(filename, 'r') as file:
-            # Read the bounding width
-            first_line = file.readline().strip()
-            if first_line.startswith("Bounding Width:"):
-                bounding_width = int(first_line.split(":")[1].strip())
-            else:
-                print("Error: Invalid bounding width format.")
-                return []
-
-            # Read the placed tiles data
+            # The bounding width comes first, or last in tile_packing --stream output
+            found_width = False
             for line in file:
                 line = line.strip()
+                if line.startswith("Bounding Width:"):
+                    bounding_width = int(line.split(":")[1].strip())
+                    found_width = True
+                    continue
+                if line.startswith("Lower Bound:"):
+                    print(f"Lower bound: {int(line.split(':')[1].strip())}")
+                    continue
                 if line:
                     data = list(map(int, line.split()))
                     x_position = data[0]
@@ -246,6 +354,9 @@ def read_placed_tiles(filename):
                         parts.append((width, height, offsetX, offsetY))
                     placed_tiles.append((x_position, parts))
 
+        if not found_width:
+            print("Error: Invalid bounding width format.")
+            return []
         print(f"Bounding width: {bounding_width}")
 
     except Exception as e:
@@ -0,0 +1,268 @@
+#pragma once
+
+#include <charconv>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include "tile_file.h"
+
+// Parses the text tile formats into TileArrays, the layout being recognized
+// from the first line: a tile list (readTiles format), the interTile/intraTile
+// layout, or a placement. A placement's Bounding Width/Height and Lower Bound
+// lines may come anywhere, e.g. last in tile_packing --stream output.
+//
+// Files are mapped and parsed in place: numbers are read with from_chars
+// straight from the mapping, with no stream or per-line string in between.
+
+inline bool startsWith(std::string_view line, std::string_view prefix) {
+    return line.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Position in a text held in memory, e.g. a MappedFile or one of its lines
+class TextCursor {
+private:
+    const char* pos;
+    const char* last;
+
+    static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f'; }
+
+public:
+    TextCursor(const char* begin, const char* end) : pos(begin), last(end) {}
+    explicit TextCursor(std::string_view text) : pos(text.data()), last(text.data() + text.size()) {}
+
+    void skipSpace() {
+        while (pos != last && isSpace(*pos)) ++pos;
+    }
+
+    // True once only whitespace is left
+    bool atEnd() {
+        skipSpace();
+        return pos == last;
+    }
+
+    // Reads an integer after any whitespace, as operator>> would
+    bool readInt(int& value) {
+        skipSpace();
+        auto [next, error] = std::from_chars(pos, last, value);
+        if (error != std::errc()) return false;
+        pos = next;
+        return true;
+    }
+
+    // Consumes c if it comes next, without skipping whitespace
+    bool consume(char c) {
+        if (pos == last || *pos != c) return false;
+        ++pos;
+        return true;
+    }
+
+    // The rest of the current line, without its "\n" or "\r\n"
+    std::string_view nextLine() {
+        const char* begin = pos;
+        while (pos != last && *pos != '\n') ++pos;
+        const char* end = pos;
+        if (pos != last) ++pos;
+        if (end != begin && end[-1] == '\r') --end;
+        return std::string_view(begin, static_cast<size_t>(end - begin));
+    }
+
+    bool exhausted() const { return pos == last; }
+};
+
+// Number of copies after a tile list part count: "2*8" is eight copies of a
+// two-part tile in a row, a bare "2" a single one
+inline int readTileCopies(std::istream& in) {
+    int copies = 1;
+    if (in.peek() == '*') {
+        in.get();
+        if (!(in >> copies) || copies < 1) {
+            std::cerr << "Invalid tile copy count.\n";
+            in.setstate(std::ios::failbit);
+            return 0;
+        }
+    }
+    return copies;
+}
+
+inline int readTileCopies(TextCursor& in) {
+    int copies = 1;
+    if (in.consume('*') && (!in.readInt(copies) || copies < 1)) {
+        std::cerr << "Invalid tile copy count.\n";
+        return 0;
+    }
+    return copies;
+}
+
+// Reads "w h dx dy" quadruples up to the end of the line
+inline bool readParts(TextCursor& line, TileArrays& tiles) {
+    int w, h, dx, dy;
+    while (!line.atEnd()) {
+        if (!line.readInt(w) || !line.readInt(h) || !line.readInt(dx) || !line.readInt(dy)) {
+            return false;
+        }
+        tiles.addPart(w, h, dx, dy);
+    }
+    return true;
+}
+
+// Part count (with an optional *copies) followed by that many parts,
+// whitespace separated (readTiles format); copies are stored one by one
+inline bool readTileList(TextCursor& in, TileArrays& tiles) {
+    tiles.layout = LAYOUT_TILE_LIST;
+    int partCount;
+    while (in.readInt(partCount)) {
+        if (partCount < 0) {
+            std::cerr << "Error reading tile part data.\n";
+            return false;
+        }
+        int copies = readTileCopies(in);
+        if (copies == 0) {
+            return false;
+        }
+        const size_t first = tiles.width.size();
+        for (int i = 0; i < partCount; ++i) {
+            int w, h, dx, dy;
+            if (!in.readInt(w) || !in.readInt(h) || !in.readInt(dx) || !in.readInt(dy)) {
+                std::cerr << "Error reading tile part data.\n";
+                return false;
+            }
+            tiles.addPart(w, h, dx, dy);
+        }
+        tiles.endTile(0, 0);
+        const size_t last = tiles.width.size();
+        for (int copy = 1; copy < copies; ++copy) {
+            for (size_t p = first; p < last; ++p) {
+                tiles.addPart(tiles.width[p], tiles.height[p], tiles.offsetX[p], tiles.offsetY[p]);
+            }
+            tiles.endTile(0, 0);
+        }
+    }
+    return in.atEnd();
+}
+
+inline bool readInterIntra(TextCursor& in, TileArrays& tiles) {
+    tiles.layout = LAYOUT_INTER_INTRA;
+    while (!in.exhausted()) {
+        std::string_view line = in.nextLine();
+        if (line.empty()) continue;
+
+        uint32_t flags;
+        if (line == "interTile") {
+            flags = TILE_INTER;
+        } else if (line == "intraTile") {
+            flags = 0;
+        } else {
+            std::cerr << "Unknown tile type: " << line << "\n";
+            return false;
+        }
+
+        if (in.exhausted()) {
+            std::cerr << "Unexpected end of file after tile type\n";
+            return false;
+        }
+        line = in.nextLine();
+        TextCursor parts(line);
+        if (!readParts(parts, tiles)) {
+            std::cerr << "Invalid tile part format: " << line << "\n";
+            return false;
+        }
+        tiles.endTile(0, flags);
+    }
+    return true;
+}
+
+// "[Placed|Preplaced] x parts" lines, with Bounding Width/Height and Lower
+// Bound lines before or after them
+inline bool readPlacements(TextCursor& in, TileArrays& tiles) {
+    tiles.layout = LAYOUT_PLACED;
+    auto readHeader = [](std::string_view line, size_t prefix, int32_t& value) {
+        TextCursor rest(line.substr(prefix));
+        int number;
+        if (!rest.readInt(number) || !rest.atEnd()) {
+            std::cerr << "Invalid header: " << line << "\n";
+            return false;
+        }
+        value = number;
+        return true;
+    };
+
+    while (!in.exhausted()) {
+        std::string_view line = in.nextLine();
+        if (line.empty()) continue;
+
+        if (startsWith(line, "Bounding Width:")) {
+            if (!readHeader(line, 15, tiles.boundingWidth)) return false;
+            continue;
+        }
+        if (startsWith(line, "Bounding Height:")) {
+            if (!readHeader(line, 16, tiles.boundingHeight)) return false;
+            tiles.layout = LAYOUT_RESULT;
+            continue;
+        }
+        if (startsWith(line, "Lower Bound:")) {
+            if (!readHeader(line, 12, tiles.lowerBound)) return false;
+            continue;
+        }
+
+        uint32_t flags = TILE_PLACED;
+        size_t prefix = 0;
+        if (startsWith(line, "Preplaced")) {
+            prefix = 9;
+            flags |= TILE_PREPLACED;
+            tiles.layout = LAYOUT_RESULT;
+        } else if (startsWith(line, "Placed")) {
+            prefix = 6;
+            tiles.layout = LAYOUT_RESULT;
+        }
+
+        TextCursor rest(line.substr(prefix));
+        int x;
+        if (!rest.readInt(x) || !readParts(rest, tiles)) {
+            std::cerr << "Invalid placed tile format: " << line << "\n";
+            return false;
+        }
+        tiles.endTile(x, flags);
+    }
+    return true;
+}
+
+// Maps the file and hands its text to parse(cursor, tiles)
+template <typename Parse>
+bool parseTextFile(const std::string& filename, TileArrays& tiles, Parse&& parse) {
+    MappedFile file;
+    if (!file.open(filename)) {
+        std::cerr << "Failed to open file: " << filename << "\n";
+        return false;
+    }
+    TextCursor in(file.begin(), file.end());
+    return parse(in, tiles);
+}
+
+// True if the line starts a placement: a header, a Placed/Preplaced prefix,
+// or "x w h dx dy" where a tile list has its part count alone
+inline bool isPlacementLine(std::string_view line) {
+    if (startsWith(line, "Bounding") || startsWith(line, "Lower Bound:") || startsWith(line, "Placed")
+        || startsWith(line, "Preplaced")) {
+        return true;
+    }
+    TextCursor numbers(line);
+    int value, count = 0;
+    while (count < 2 && numbers.readInt(value)) ++count;
+    return count == 2;
+}
+
+// Any of the layouts, recognized from the first non-empty line
+inline bool readAnyLayout(TextCursor& in, TileArrays& tiles) {
+    TextCursor probe = in;
+    std::string_view first;
+    while (!probe.exhausted() && (first = probe.nextLine()).empty()) {}
+
+    if (isPlacementLine(first)) return readPlacements(in, tiles);
+    if (first == "interTile" || first == "intraTile") return readInterIntra(in, tiles);
+    return readTileList(in, tiles);
+}
+
+inline bool readTextTiles(const std::string& filename, TileArrays& tiles) {
+    return parseTextFile(filename, tiles, readAnyLayout);
+}
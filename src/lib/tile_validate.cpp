@@ -0,0 +1,92 @@
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "tile_file.h"
+#include "tile_text.h"
+#include "collision_index.h"
+
+// Checks a finished placement instead of eyeballing draw_packing: no two
+// tiles may share a cell, and the recorded bounding width must reach the
+// rightmost tile edge.
+//
+//   tile_validate placed_tiles.txt
+//   tile_validate all_tiles.tpk
+//
+// Accepts placed_tiles.txt, all_tiles.txt / result_tiles.txt or their .tpk
+// versions. Exits with 1 when the placement is invalid.
+
+template <typename Tiles>
+static int validate(const Tiles& tiles, int boundingWidth) {
+    int rightmost = 0;
+    for (size_t i = 0; i < tiles.tileCount(); ++i) {
+        for (int p = tiles.partBegin[i]; p < tiles.partBegin[i + 1]; ++p) {
+            if (tiles.width[p] > 0 && tiles.height[p] > 0) {
+                rightmost = std::max(rightmost, tiles.positionX[i] + tiles.offsetX[p] + tiles.width[p]);
+            }
+        }
+    }
+
+    const size_t limit = 20;
+    std::vector<Overlap> overlaps = findOverlaps(tiles, limit);
+    for (const auto& overlap : overlaps) {
+        std::cout << "Tiles " << overlap.first + 1 << " (x = " << tiles.positionX[overlap.first] << ") and "
+                  << overlap.second + 1 << " (x = " << tiles.positionX[overlap.second] << ") overlap at row "
+                  << overlap.row << ", column " << overlap.column << "\n";
+    }
+    if (overlaps.size() >= limit) {
+        std::cout << "Stopped after " << limit << " overlaps.\n";
+    }
+
+    bool widthOk = boundingWidth < 0 || boundingWidth >= rightmost;
+    if (!widthOk) {
+        std::cout << "Bounding width " << boundingWidth << " is below the rightmost tile edge " << rightmost << "\n";
+    }
+
+    std::cout << tiles.tileCount() << " tiles, rightmost edge " << rightmost;
+    if (boundingWidth >= 0) {
+        std::cout << ", bounding width " << boundingWidth;
+    }
+    std::cout << "\n";
+
+    if (!overlaps.empty() || !widthOk) {
+        std::cout << "Placement is invalid.\n";
+        return 1;
+    }
+    std::cout << "Placement is valid.\n";
+    return 0;
+}
+
+static bool isPlacement(uint32_t layout) {
+    return layout == LAYOUT_PLACED || layout == LAYOUT_RESULT;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::cerr << "Usage: tile_validate <placement>\n";
+        return -1;
+    }
+    const std::string input = argv[1];
+
+    if (isTileFile(input)) {
+        TileFileView view;
+        if (!view.open(input)) {
+            return -1;
+        }
+        if (!isPlacement(view.header->layout)) {
+            std::cerr << "Not a placement: " << input << "\n";
+            return -1;
+        }
+        return validate(view, view.header->boundingWidth);
+    }
+
+    TileArrays tiles;
+    if (!readTextTiles(input, tiles)) {
+        return -1;
+    }
+    if (!isPlacement(tiles.layout)) {
+        std::cerr << "Not a placement: " << input << "\n";
+        return -1;
+    }
+    return validate(tiles, tiles.boundingWidth);
+}
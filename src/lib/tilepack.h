@@ -0,0 +1,159 @@
+#pragma once
+
+// C interface to the first-fit tile packer in tile_packing.h, built as a
+// shared library so callers can pack without spawning tile_packing.exe and
+// round-tripping through test_tiles.txt / placed_tiles.txt:
+//
+//   g++ -O2 -std=c++17 -shared -fPIC -pthread tilepack_api.cpp -o libtilepack.so
+//   g++ -O2 -std=c++17 -shared tilepack_api.cpp -o tilepack.dll   (MinGW)
+//
+// All buffers are owned by the caller. Apart from tp_read_tiles, which reads
+// the file it is given and reports malformed lines on stderr, the library
+// does no file I/O and prints nothing.
+
+#ifdef _WIN32
+#define TILEPACK_API __declspec(dllexport)
+#else
+#define TILEPACK_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Return codes
+#define TP_OK 0
+#define TP_INVALID_INPUT -1  // Null buffer, negative count or a part outside the grid
+#define TP_NO_FIT -2         // A tile did not fit within MAX_WIDTH
+#define TP_BUFFER_TOO_SMALL -3  // An output buffer is too small; the size needed is reported
+
+// Packs tiles in the given order with leftmost first-fit.
+//   tileCount      number of tiles
+//   partCounts     [tileCount] number of parts of each tile
+//   parts          [4 * total parts] width, height, offsetX, offsetY of every
+//                  part, tile after tile
+//   positionsX     [tileCount] out: x position of each placed tile
+//   boundingWidth  out: right edge of the packing
+// On TP_NO_FIT, positionsX holds -1 for the tile that failed and all after it.
+TILEPACK_API int tp_pack(int tileCount, const int* partCounts, const int* parts,
+                         int* positionsX, int* boundingWidth);
+
+// Packs the tiles once per (seam, ratio) point after splitting them at the
+// seam and widening the inter-module tiles by 2 * (ratio - 1), see
+// seam_sweep.h. Points are packed concurrently on `threads` threads
+// (0 = one per core).
+//   tileCount, partCounts, parts   base tiles, as for tp_pack
+//   seams, seamCount               seam positions (0 = no seam)
+//   ratios, ratioCount             inter/intra gate time ratios
+//   sortByArea                     nonzero to stable-sort each point's tiles by area
+//   widths                         [seamCount * ratioCount] out: bounding width of
+//                                  each point, row-major by seam; -1 if a tile did not fit
+TILEPACK_API int tp_sweep(int tileCount, const int* partCounts, const int* parts,
+                          const int* seams, int seamCount, const int* ratios, int ratioCount,
+                          int sortByArea, int threads, int* widths);
+
+// Packs a device of seamCount + 1 modules (see module_packing.h): the tiles
+// crossing a seam are widened by 2 * (ratio - 1) and keep that seam's
+// separation, the modules are packed concurrently on `threads` threads
+// (0 = one per core) and the inter-module tiles placed after them.
+//   tileCount, partCounts, parts   base tiles, as for tp_pack
+//   seamCount, seams               seam rows, any order
+//   separations, ratios            [seamCount] per seam; either may be null
+//                                  for separation 0 / ratio 1
+//   sortByArea                     nonzero to stable-sort each group by area
+//   moduleWidths                   [seamCount + 1] out, may be null: width of each
+//                                  module's intra tiles, bottom module first
+//   boundingWidth                  out: width of the whole device
+TILEPACK_API int tp_pack_modules(int tileCount, const int* partCounts, const int* parts,
+                                 int seamCount, const int* seams, const int* separations, const int* ratios,
+                                 int sortByArea, int threads, int* moduleWidths, int* boundingWidth);
+
+// Packs the tiles once per gradient threshold, reusing packer state between
+// thresholds (see epsilon_sweep.h). Threshold t packs, in the given order,
+// the tiles whose |gradient| > t.
+//   tileCount, partCounts, parts   tiles, as for tp_pack
+//   gradients                      [tileCount] gradient of each tile's excitation
+//   thresholds, thresholdCount     epsilon values, any order
+//   orderByGradient                nonzero to stable-sort tiles by decreasing |gradient|
+//                                  first, which makes the sweep a single pass
+//   widths                         [thresholdCount] out: bounding width per threshold,
+//                                  -1 if a tile did not fit
+TILEPACK_API int tp_epsilon_sweep(int tileCount, const int* partCounts, const int* parts,
+                                  const double* gradients, const double* thresholds, int thresholdCount,
+                                  int orderByGradient, int* widths);
+
+// Lower bound on the bounding width of any packing of the tiles (the best of
+// the bounds in lower_bounds.h)
+//   tileCount, partCounts, parts   tiles, as for tp_pack
+//   lowerBound                     out: the bound
+TILEPACK_API int tp_lower_bound(int tileCount, const int* partCounts, const int* parts, int* lowerBound);
+
+// Packs the heuristic orders of ordering_search.h plus `randomStarts`
+// random perturbations of them on `threads` threads (0 = one per core) and
+// returns the order with the smallest bounding width. Runs stop early once
+// they are wider than the best so far. Every run is packed, even once one
+// reaches the lower bound, so the result is the same for any thread count.
+//   tileCount, partCounts, parts   tiles, as for tp_pack
+//   randomStarts, seed             number and seed of the perturbed orders
+//   order                          [tileCount] out: best order, as tile indices
+//   boundingWidth                  out: its bounding width
+TILEPACK_API int tp_search_orderings(int tileCount, const int* partCounts, const int* parts,
+                                     int randomStarts, unsigned seed, int threads,
+                                     int* order, int* boundingWidth);
+
+// Improves a packing order by simulated annealing for `seconds` (see
+// local_search.h), or until it reaches the lower bound. Each move repacks
+// only the tiles after the first changed position, starting from a saved
+// packer snapshot.
+//   tileCount, partCounts, parts   tiles, as for tp_pack
+//   order                          [tileCount] in: starting order as tile indices,
+//                                  e.g. from tp_search_orderings; out: best order found
+//   seconds, seed                  time budget and random seed
+//   onImprovement                  optional; called with the elapsed seconds and
+//                                  the new best width whenever it improves
+//   boundingWidth                  out: width of the best order
+TILEPACK_API int tp_anneal(int tileCount, const int* partCounts, const int* parts,
+                           int* order, double seconds, unsigned seed,
+                           void (*onImprovement)(double seconds, int boundingWidth),
+                           int* boundingWidth);
+
+// Generates the circuit tiles of the excitations whose |gradient| > epsilon,
+// with the same tiles and order as create_gradient_tiles in tile_process.py
+// (see tile_generation.h). Every tile has a single part.
+//   excitationCount  number of excitations
+//   orbitalCounts    [excitationCount] 1 for a single, 2 for a double excitation
+//   orbitals         the a orbitals then the i orbitals of every excitation,
+//                    2 * orbitalCounts[e] values each
+//   gradients        [excitationCount] gradient of each excitation, or null to keep all
+//   fOrbs, fOrbCount fragment orbital counts for orbital_reordering; 0 to skip it
+//   capacity         tiles the output buffers hold; 8 per excitation always suffices
+//   parts            [4 * capacity] out: width, height, offsetX, offsetY of every tile
+//   tileGradients    [capacity] out, may be null: |gradient| of each tile's excitation
+//   tileCount        out: number of tiles; on TP_BUFFER_TOO_SMALL the capacity needed
+TILEPACK_API int tp_generate_tiles(int excitationCount, const int* orbitalCounts, const int* orbitals,
+                                   const double* gradients, double epsilon, const int* fOrbs, int fOrbCount,
+                                   int capacity, int* parts, double* tileGradients, int* tileCount);
+
+// Reads a tile or placement file: any of the text layouts (tile list,
+// interTile/intraTile, placements with or without Bounding Width/Height
+// headers and Placed/Preplaced prefixes) or a .tpk file. Text is mapped and
+// parsed in place (tile_text.h); tile list copies "n*k" come out one by one.
+//   filename                     path of the file
+//   tileCapacity, partCapacity   tiles and parts the output buffers hold
+//   partCounts                   [tileCapacity] out: number of parts of each tile
+//   parts                        [4 * partCapacity] out: width, height, offsetX,
+//                                offsetY of every part, tile after tile
+//   positionsX, flags            [tileCapacity] out, may be null: x of each tile (0 if
+//                                not placed) and its TileFlags (1 placed, 2 preplaced, 4 inter)
+//   info                         [4] out, may be null: layout (TileFileLayout), bounding
+//                                width, bounding height (-1 when not in the file), lower bound
+//   tileCount, partCount         out: tiles and parts read; on TP_BUFFER_TOO_SMALL the
+//                                capacities needed
+// Returns TP_INVALID_INPUT if the file cannot be opened or is malformed.
+TILEPACK_API int tp_read_tiles(const char* filename, int tileCapacity, int partCapacity,
+                               int* partCounts, int* parts, int* positionsX, int* flags, int* info,
+                               int* tileCount, int* partCount);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,327 @@
+#include "tilepack.h"
+#include "tile_packing.h"
+#include "seam_sweep.h"
+#include "module_packing.h"
+#include "epsilon_sweep.h"
+#include "ordering_search.h"
+#include "local_search.h"
+#include "tile_generation.h"
+#include "tile_text.h"
+
+// Builds Tile objects from the flat part arrays of the C interface
+static int buildTiles(int tileCount, const int* partCounts, const int* parts, std::vector<Tile>& tiles) {
+    if (tileCount < 0 || (tileCount > 0 && (!partCounts || !parts))) {
+        return TP_INVALID_INPUT;
+    }
+
+    tiles.reserve(tileCount);
+    const int* part = parts;
+    for (int i = 0; i < tileCount; ++i) {
+        if (partCounts[i] < 0) return TP_INVALID_INPUT;
+
+        std::vector<TilePart> tileParts;
+        tileParts.reserve(partCounts[i]);
+        for (int j = 0; j < partCounts[i]; ++j, part += 4) {
+            int w = part[0], h = part[1], dx = part[2], dy = part[3];
+            if (w < 0 || h < 0 || dx < 0 || dy < 0 || dy + h > MAX_HEIGHT) return TP_INVALID_INPUT;
+            tileParts.emplace_back(w, h, dx, dy);
+        }
+        tiles.emplace_back(tileParts);
+    }
+    return TP_OK;
+}
+
+extern "C" TILEPACK_API int tp_pack(int tileCount, const int* partCounts, const int* parts,
+                                    int* positionsX, int* boundingWidth) {
+    if (!boundingWidth || (tileCount > 0 && !positionsX)) {
+        return TP_INVALID_INPUT;
+    }
+
+    std::vector<Tile> tiles;
+    int status = buildTiles(tileCount, partCounts, parts, tiles);
+    if (status != TP_OK) {
+        return status;
+    }
+
+    TilePacker<DefaultGrid> packer(tiles, makeDefaultGrid());
+    bool packed = packer.packTiles();
+
+    const auto& placedTiles = packer.getPlacedTiles();
+    for (int i = 0; i < tileCount; ++i) {
+        positionsX[i] = (i < static_cast<int>(placedTiles.size())) ? placedTiles[i].positionX : -1;
+    }
+    *boundingWidth = packer.getBoundingWidth();
+
+    return packed ? TP_OK : TP_NO_FIT;
+}
+
+extern "C" TILEPACK_API int tp_sweep(int tileCount, const int* partCounts, const int* parts,
+                                     const int* seams, int seamCount, const int* ratios, int ratioCount,
+                                     int sortByArea, int threads, int* widths) {
+    if (seamCount < 0 || ratioCount < 0 || (seamCount > 0 && !seams) || (ratioCount > 0 && !ratios)
+        || (seamCount > 0 && ratioCount > 0 && !widths)) {
+        return TP_INVALID_INPUT;
+    }
+
+    std::vector<Tile> tiles;
+    int status = buildTiles(tileCount, partCounts, parts, tiles);
+    if (status != TP_OK) {
+        return status;
+    }
+
+    std::vector<int> result = sweepSeamsAndRatios(tiles, std::vector<int>(seams, seams + seamCount),
+                                                  std::vector<int>(ratios, ratios + ratioCount),
+                                                  sortByArea != 0, threads);
+    std::copy(result.begin(), result.end(), widths);
+    return std::find(result.begin(), result.end(), -1) == result.end() ? TP_OK : TP_NO_FIT;
+}
+
+extern "C" TILEPACK_API int tp_pack_modules(int tileCount, const int* partCounts, const int* parts,
+                                            int seamCount, const int* seams, const int* separations,
+                                            const int* ratios, int sortByArea, int threads, int* moduleWidths,
+                                            int* boundingWidth) {
+    if (seamCount < 0 || (seamCount > 0 && !seams) || !boundingWidth) {
+        return TP_INVALID_INPUT;
+    }
+
+    std::vector<Tile> tiles;
+    int status = buildTiles(tileCount, partCounts, parts, tiles);
+    if (status != TP_OK) {
+        return status;
+    }
+
+    std::vector<Seam> moduleSeams;
+    for (int s = 0; s < seamCount; ++s) {
+        Seam seam{seams[s]};
+        seam.separation = separations ? separations[s] : 0;
+        seam.ratio = ratios ? ratios[s] : 1;
+        if (seam.separation < 0 || seam.ratio < 1) {
+            return TP_INVALID_INPUT;
+        }
+        moduleSeams.push_back(seam);
+    }
+
+    ModulePacking packing = packModules(tiles, moduleSeams, sortByArea != 0, threads);
+    if (moduleWidths) {
+        std::copy(packing.moduleWidths.begin(), packing.moduleWidths.end(), moduleWidths);
+    }
+    *boundingWidth = packing.packer.getBoundingWidth();
+    return packing.complete ? TP_OK : TP_NO_FIT;
+}
+
+extern "C" TILEPACK_API int tp_epsilon_sweep(int tileCount, const int* partCounts, const int* parts,
+                                             const double* gradients, const double* thresholds, int thresholdCount,
+                                             int orderByGradient, int* widths) {
+    if (thresholdCount < 0 || (tileCount > 0 && !gradients) || (thresholdCount > 0 && (!thresholds || !widths))) {
+        return TP_INVALID_INPUT;
+    }
+
+    std::vector<Tile> tiles;
+    int status = buildTiles(tileCount, partCounts, parts, tiles);
+    if (status != TP_OK) {
+        return status;
+    }
+
+    std::vector<int> result = sweepEpsilons(tiles, std::vector<double>(gradients, gradients + tileCount),
+                                            std::vector<double>(thresholds, thresholds + thresholdCount),
+                                            orderByGradient != 0);
+    std::copy(result.begin(), result.end(), widths);
+    return std::find(result.begin(), result.end(), -1) == result.end() ? TP_OK : TP_NO_FIT;
+}
+
+extern "C" TILEPACK_API int tp_lower_bound(int tileCount, const int* partCounts, const int* parts, int* lowerBound) {
+    if (!lowerBound) {
+        return TP_INVALID_INPUT;
+    }
+
+    std::vector<Tile> tiles;
+    int status = buildTiles(tileCount, partCounts, parts, tiles);
+    if (status != TP_OK) {
+        return status;
+    }
+
+    *lowerBound = computeLowerBounds(tiles).best();
+    return TP_OK;
+}
+
+extern "C" TILEPACK_API int tp_search_orderings(int tileCount, const int* partCounts, const int* parts,
+                                                int randomStarts, unsigned seed, int threads,
+                                                int* order, int* boundingWidth) {
+    if (randomStarts < 0 || !boundingWidth || (tileCount > 0 && !order)) {
+        return TP_INVALID_INPUT;
+    }
+
+    std::vector<Tile> tiles;
+    int status = buildTiles(tileCount, partCounts, parts, tiles);
+    if (status != TP_OK) {
+        return status;
+    }
+
+    // No target width: stopping at the lower bound would make the order
+    // returned depend on which thread got there first
+    OrderingResult result = searchOrderings(tiles, randomStarts, seed, threads);
+    *boundingWidth = result.width;
+    if (result.width == -1) {
+        return TP_NO_FIT;
+    }
+    std::copy(result.order.begin(), result.order.end(), order);
+    return TP_OK;
+}
+
+extern "C" TILEPACK_API int tp_anneal(int tileCount, const int* partCounts, const int* parts,
+                                      int* order, double seconds, unsigned seed,
+                                      void (*onImprovement)(double seconds, int boundingWidth),
+                                      int* boundingWidth) {
+    if (!boundingWidth || (tileCount > 0 && !order) || !(seconds >= 0)) {
+        return TP_INVALID_INPUT;
+    }
+
+    std::vector<Tile> tiles;
+    int status = buildTiles(tileCount, partCounts, parts, tiles);
+    if (status != TP_OK) {
+        return status;
+    }
+
+    // The starting order must be a permutation of the tiles
+    std::vector<int> start(order, order + tileCount);
+    std::vector<bool> seen(tileCount, false);
+    for (int index : start) {
+        if (index < 0 || index >= tileCount || seen[index]) return TP_INVALID_INPUT;
+        seen[index] = true;
+    }
+
+    AnnealOptions options;
+    options.seconds = seconds;
+    options.seed = seed;
+    options.targetWidth = computeLowerBounds(tiles).best();
+    if (onImprovement) {
+        options.onImprovement = onImprovement;
+    }
+
+    // Snapshots of the column mask grid are a fraction of the cost of the
+    // default grid's, so use it whenever the tiles stay below row 64
+    bool maskFits = true;
+    for (const auto& tile : tiles) {
+        maskFits = maskFits && tile.getTotalHeight() <= ColumnMaskGrid::MAX_ROWS;
+    }
+    AnnealResult result = maskFits
+        ? annealOrder(tiles, start, ColumnMaskGrid(), options)
+        : annealOrder(tiles, start, makeDefaultGrid(), options);
+
+    *boundingWidth = result.width;
+    if (result.width == -1) {
+        return TP_NO_FIT;
+    }
+    std::copy(result.order.begin(), result.order.end(), order);
+    return TP_OK;
+}
+
+extern "C" TILEPACK_API int tp_generate_tiles(int excitationCount, const int* orbitalCounts, const int* orbitals,
+                                              const double* gradients, double epsilon, const int* fOrbs,
+                                              int fOrbCount, int capacity, int* parts, double* tileGradients,
+                                              int* tileCount) {
+    if (!tileCount || excitationCount < 0 || fOrbCount < 0 || capacity < 0
+        || (excitationCount > 0 && (!orbitalCounts || !orbitals)) || (fOrbCount > 0 && !fOrbs)
+        || (capacity > 0 && !parts)) {
+        return TP_INVALID_INPUT;
+    }
+
+    std::vector<Excitation> excitations(excitationCount);
+    const int* orbital = orbitals;
+    for (int e = 0; e < excitationCount; ++e) {
+        int count = orbitalCounts[e];
+        if (count != 1 && count != 2) return TP_INVALID_INPUT;
+        excitations[e].a.assign(orbital, orbital + count);
+        excitations[e].i.assign(orbital + count, orbital + 2 * count);
+        orbital += 2 * count;
+        if (gradients) {
+            excitations[e].gradient = std::abs(gradients[e]);
+        }
+    }
+
+    std::vector<double> tileGradientList;
+    int skipped = 0;
+    std::vector<Tile> tiles = generateTiles(excitations, epsilon, std::vector<int>(fOrbs, fOrbs + fOrbCount),
+                                            &tileGradientList, &skipped);
+    if (skipped > 0) {
+        return TP_INVALID_INPUT;
+    }
+
+    *tileCount = static_cast<int>(tiles.size());
+    if (*tileCount > capacity) {
+        return TP_BUFFER_TOO_SMALL;
+    }
+    for (size_t t = 0; t < tiles.size(); ++t) {
+        const TilePart& part = tiles[t].parts.front();
+        parts[4 * t] = part.width;
+        parts[4 * t + 1] = part.height;
+        parts[4 * t + 2] = part.offsetX;
+        parts[4 * t + 3] = part.offsetY;
+        if (tileGradients) {
+            tileGradients[t] = tileGradientList[t];
+        }
+    }
+    return TP_OK;
+}
+
+// Copies the tiles read by tp_read_tiles out of a TileFileView or TileArrays
+template <typename Arrays>
+static int copyTiles(const Arrays& tiles, int tileCapacity, int partCapacity, int* partCounts, int* parts,
+                     int* positionsX, int* flags, int* tileCount, int* partCount) {
+    size_t count = tiles.tileCount();
+    *tileCount = static_cast<int>(count);
+    *partCount = tiles.partBegin[count];
+    if (*tileCount > tileCapacity || *partCount > partCapacity) {
+        return TP_BUFFER_TOO_SMALL;
+    }
+    if ((*tileCount > 0 && !partCounts) || (*partCount > 0 && !parts)) {
+        return TP_INVALID_INPUT;
+    }
+
+    for (size_t t = 0; t < count; ++t) {
+        partCounts[t] = tiles.partBegin[t + 1] - tiles.partBegin[t];
+        if (positionsX) positionsX[t] = tiles.positionX[t];
+        if (flags) flags[t] = static_cast<int>(tiles.flags[t]);
+    }
+    for (int p = 0; p < *partCount; ++p) {
+        parts[4 * p] = tiles.width[p];
+        parts[4 * p + 1] = tiles.height[p];
+        parts[4 * p + 2] = tiles.offsetX[p];
+        parts[4 * p + 3] = tiles.offsetY[p];
+    }
+    return TP_OK;
+}
+
+extern "C" TILEPACK_API int tp_read_tiles(const char* filename, int tileCapacity, int partCapacity,
+                                          int* partCounts, int* parts, int* positionsX, int* flags, int* info,
+                                          int* tileCount, int* partCount) {
+    if (!filename || !tileCount || !partCount || tileCapacity < 0 || partCapacity < 0) {
+        return TP_INVALID_INPUT;
+    }
+
+    if (isTileFile(filename)) {
+        TileFileView view;
+        if (!view.open(filename)) {
+            return TP_INVALID_INPUT;
+        }
+        if (info) {
+            info[0] = static_cast<int>(view.header->layout);
+            info[1] = view.header->boundingWidth;
+            info[2] = view.header->boundingHeight;
+            info[3] = view.header->lowerBound;
+        }
+        return copyTiles(view, tileCapacity, partCapacity, partCounts, parts, positionsX, flags, tileCount, partCount);
+    }
+
+    TileArrays tiles;
+    if (!readTextTiles(filename, tiles)) {
+        return TP_INVALID_INPUT;
+    }
+    if (info) {
+        info[0] = static_cast<int>(tiles.layout);
+        info[1] = tiles.boundingWidth;
+        info[2] = tiles.boundingHeight;
+        info[3] = tiles.lowerBound;
+    }
+    return copyTiles(tiles, tileCapacity, partCapacity, partCounts, parts, positionsX, flags, tileCount, partCount);
+}